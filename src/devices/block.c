@@ -6,6 +6,7 @@
 
 #include "devices/ide.h"
 #include "threads/malloc.h"
+#include "threads/trace.h"
 
 /** A block device. */
 struct block {
@@ -94,7 +95,9 @@ static void check_sector(struct block *block, block_sector_t sector) {
    per-block device locking is unneeded. */
 void block_read(struct block *block, block_sector_t sector, void *buffer) {
   check_sector(block, sector);
+  TRACE_EVENT(READ_BEGIN, sector);
   block->ops->read(block->aux, sector, buffer);
+  TRACE_EVENT(READ_END, sector);
   block->read_cnt++;
 }
 
@@ -106,7 +109,9 @@ void block_read(struct block *block, block_sector_t sector, void *buffer) {
 void block_write(struct block *block, block_sector_t sector, const void *buffer) {
   check_sector(block, sector);
   ASSERT(block->type != BLOCK_FOREIGN);
+  TRACE_EVENT(WRITE_BEGIN, sector);
   block->ops->write(block->aux, sector, buffer);
+  TRACE_EVENT(WRITE_END, sector);
   block->write_cnt++;
 }
 
@@ -119,6 +124,13 @@ const char *block_name(struct block *block) { return block->name; }
 /** Returns BLOCK's type. */
 enum block_type block_type(struct block *block) { return block->type; }
 
+/** Stores the number of sectors read from and written to BLOCK
+   in *READ_CNT and *WRITE_CNT. */
+void block_get_stats(struct block *block, unsigned long long *read_cnt, unsigned long long *write_cnt) {
+  *read_cnt = block->read_cnt;
+  *write_cnt = block->write_cnt;
+}
+
 /** Prints statistics for each block device used for a Pintos role. */
 void block_print_stats(void) {
   int i;
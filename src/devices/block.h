@@ -56,6 +56,7 @@ const char *block_name(struct block *);
 enum block_type block_type(struct block *);
 
 /** Statistics. */
+void block_get_stats(struct block *, unsigned long long *read_cnt, unsigned long long *write_cnt);
 void block_print_stats(void);
 
 /** Lower-level interface to block device drivers. */
@@ -314,7 +314,9 @@ static void ide_read(void *d_, block_sector_t sec_no, void *buffer) {
   lock_acquire(&c->lock);
   select_sector(d, sec_no);
   issue_pio_command(c, CMD_READ_SECTOR_RETRY);
+  enum thread_wait old_wait = thread_set_wait(WAIT_IO);
   sema_down(&c->completion_wait);
+  thread_set_wait(old_wait);
   if (!wait_while_busy(d)) PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
   input_sector(c, buffer);
   lock_release(&c->lock);
@@ -333,7 +335,9 @@ static void ide_write(void *d_, block_sector_t sec_no, const void *buffer) {
   issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
   if (!wait_while_busy(d)) PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
   output_sector(c, buffer);
+  enum thread_wait old_wait = thread_set_wait(WAIT_IO);
   sema_down(&c->completion_wait);
+  thread_set_wait(old_wait);
   lock_release(&c->lock);
 }
 
@@ -32,6 +32,19 @@ uint8_t input_getc(void) {
   return key;
 }
 
+/** Retrieves SIZE keys from the input buffer into KEYS, waiting
+   for keys to be pressed as necessary. */
+void input_read(uint8_t *keys, size_t size) {
+  enum intr_level old_level = intr_disable();
+  while (size > 0) {
+    size_t n = intq_read(&buffer, keys, size);
+    keys += n;
+    size -= n;
+    serial_notify();
+  }
+  intr_set_level(old_level);
+}
+
 /** Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
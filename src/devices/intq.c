@@ -1,30 +1,31 @@
 #include "devices/intq.h"
 
 #include <debug.h>
+#include <string.h>
 
 #include "threads/thread.h"
 
-static int next(int pos);
-static void wait(struct intq *q, struct thread **waiter);
-static void signal(struct intq *q, struct thread **waiter);
+static size_t used(const struct intq *q);
+static void wait(struct intq *q, struct list *waiters);
+static void signal(struct intq *q, struct list *waiters);
 
 /** Initializes interrupt queue Q. */
 void intq_init(struct intq *q) {
-  lock_init(&q->lock);
-  q->not_full = q->not_empty = NULL;
+  list_init(&q->not_full);
+  list_init(&q->not_empty);
   q->head = q->tail = 0;
 }
 
 /** Returns true if Q is empty, false otherwise. */
 bool intq_empty(const struct intq *q) {
   ASSERT(intr_get_level() == INTR_OFF);
-  return q->head == q->tail;
+  return used(q) == 0;
 }
 
 /** Returns true if Q is full, false otherwise. */
 bool intq_full(const struct intq *q) {
   ASSERT(intr_get_level() == INTR_OFF);
-  return next(q->head) == q->tail;
+  return used(q) == INTQ_BUFSIZE;
 }
 
 /** Removes a byte from Q and returns it.
@@ -34,15 +35,9 @@ uint8_t intq_getc(struct intq *q) {
   uint8_t byte;
 
   ASSERT(intr_get_level() == INTR_OFF);
-  while (intq_empty(q)) {
-    ASSERT(!intr_context());
-    lock_acquire(&q->lock);
-    wait(q, &q->not_empty);
-    lock_release(&q->lock);
-  }
+  while (intq_empty(q)) wait(q, &q->not_empty);
 
-  byte = q->buf[q->tail];
-  q->tail = next(q->tail);
+  byte = q->buf[q->tail++ & (INTQ_BUFSIZE - 1)];
   signal(q, &q->not_full);
   return byte;
 }
@@ -52,42 +47,95 @@ uint8_t intq_getc(struct intq *q) {
    When called from an interrupt handler, Q must not be full. */
 void intq_putc(struct intq *q, uint8_t byte) {
   ASSERT(intr_get_level() == INTR_OFF);
-  while (intq_full(q)) {
-    ASSERT(!intr_context());
-    lock_acquire(&q->lock);
-    wait(q, &q->not_full);
-    lock_release(&q->lock);
-  }
+  while (intq_full(q)) wait(q, &q->not_full);
 
-  q->buf[q->head] = byte;
-  q->head = next(q->head);
+  q->buf[q->head++ & (INTQ_BUFSIZE - 1)] = byte;
   signal(q, &q->not_empty);
 }
 
-/** Returns the position after POS within an intq. */
-static int next(int pos) { return (pos + 1) % INTQ_BUFSIZE; }
+/** Removes up to SIZE bytes from Q into BUFFER and returns the
+   number removed.  If Q is empty, first sleeps until a byte is
+   added, so that the return value is 0 only if SIZE is.  When
+   called from an interrupt handler, never sleeps, and returns 0
+   if Q is empty. */
+size_t intq_read(struct intq *q, void *buffer, size_t size) {
+  size_t ofs, chunk;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (size == 0) return 0;
+  while (intq_empty(q)) {
+    if (intr_context()) return 0;
+    wait(q, &q->not_empty);
+  }
+
+  /* Copy in at most two pieces, on either side of the wrap. */
+  if (size > used(q)) size = used(q);
+  ofs = q->tail & (INTQ_BUFSIZE - 1);
+  chunk = size < INTQ_BUFSIZE - ofs ? size : INTQ_BUFSIZE - ofs;
+  memcpy(buffer, q->buf + ofs, chunk);
+  memcpy((uint8_t *)buffer + chunk, q->buf, size - chunk);
+  q->tail += size;
+
+  signal(q, &q->not_full);
+  return size;
+}
+
+/** Adds the SIZE bytes in BUFFER to the end of Q, sleeping
+   whenever Q is full until bytes are removed, and returns SIZE.
+   When called from an interrupt handler, never sleeps, and
+   returns the number of bytes that fit. */
+size_t intq_write(struct intq *q, const void *buffer, size_t size) {
+  const uint8_t *src = buffer;
+  size_t left = size;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  while (left > 0) {
+    size_t n, ofs, chunk;
+
+    while (intq_full(q)) {
+      if (intr_context()) return size - left;
+      wait(q, &q->not_full);
+    }
+
+    n = left < INTQ_BUFSIZE - used(q) ? left : INTQ_BUFSIZE - used(q);
+    ofs = q->head & (INTQ_BUFSIZE - 1);
+    chunk = n < INTQ_BUFSIZE - ofs ? n : INTQ_BUFSIZE - ofs;
+    memcpy(q->buf + ofs, src, chunk);
+    memcpy(q->buf, src + chunk, n - chunk);
+    q->head += n;
+    src += n;
+    left -= n;
+
+    signal(q, &q->not_empty);
+  }
+  return size;
+}
+
+/** Returns the number of bytes in Q. */
+static size_t used(const struct intq *q) { return q->head - q->tail; }
 
-/** WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
-static void wait(struct intq *q UNUSED, struct thread **waiter) {
+/** WAITERS must be Q's not_empty or not_full list.  Sleeps on
+   WAITERS until signal() wakes it up.  The caller must recheck
+   its condition, since another thread woken along with it may
+   have used up the bytes or space first. */
+static void wait(struct intq *q UNUSED, struct list *waiters) {
   ASSERT(!intr_context());
   ASSERT(intr_get_level() == INTR_OFF);
-  ASSERT((waiter == &q->not_empty && intq_empty(q)) || (waiter == &q->not_full && intq_full(q)));
+  ASSERT((waiters == &q->not_empty && intq_empty(q)) || (waiters == &q->not_full && intq_full(q)));
 
-  *waiter = thread_current();
+  list_push_back(waiters, &thread_current()->elem);
+  enum thread_wait old_wait = thread_set_wait(WAIT_IO);
   thread_block();
+  thread_set_wait(old_wait);
 }
 
-/** WAITER must be the address of Q's not_empty or not_full
-   member, and the associated condition must be true.  If a
-   thread is waiting for the condition, wakes it up and resets
-   the waiting thread. */
-static void signal(struct intq *q UNUSED, struct thread **waiter) {
+/** WAITERS must be Q's not_empty or not_full list, and the
+   associated condition must be true.  Wakes up every thread
+   waiting for the condition: a batch operation may have made
+   room for, or added bytes for, more than one of them. */
+static void signal(struct intq *q UNUSED, struct list *waiters) {
   ASSERT(intr_get_level() == INTR_OFF);
-  ASSERT((waiter == &q->not_empty && !intq_empty(q)) || (waiter == &q->not_full && !intq_full(q)));
+  ASSERT((waiters == &q->not_empty && !intq_empty(q)) || (waiters == &q->not_full && !intq_full(q)));
 
-  if (*waiter != NULL) {
-    thread_unblock(*waiter);
-    *waiter = NULL;
-  }
+  while (!list_empty(waiters)) thread_unblock(container_of(list_pop_front(waiters), struct thread, elem));
 }
@@ -1,8 +1,11 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
+#include <list.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "threads/interrupt.h"
-#include "threads/synch.h"
 
 /** An "interrupt queue", a circular buffer shared between
    kernel threads and external interrupt handlers.
@@ -17,20 +20,25 @@
    protect kernel threads from one another, not from interrupt
    handlers. */
 
-/** Queue buffer size, in bytes. */
-#define INTQ_BUFSIZE 64
+/** Queue buffer size, in bytes.  Must be a power of 2, so that
+   positions wrap around with a mask instead of a division. */
+#define INTQ_BUFSIZE 1024
+#if (INTQ_BUFSIZE & (INTQ_BUFSIZE - 1)) != 0
+#error INTQ_BUFSIZE must be a power of 2
+#endif
 
 /** A circular queue of bytes. */
 struct intq {
   /* Waiting threads. */
-  struct lock lock;         /**< Only one thread may wait at once. */
-  struct thread *not_full;  /**< Thread waiting for not-full condition. */
-  struct thread *not_empty; /**< Thread waiting for not-empty condition. */
+  struct list not_full;  /**< Threads waiting for not-full condition. */
+  struct list not_empty; /**< Threads waiting for not-empty condition. */
 
-  /* Queue. */
+  /* Queue.  HEAD and TAIL count bytes ever written and read, so
+     HEAD - TAIL is the number of bytes in the queue and all
+     INTQ_BUFSIZE bytes of BUF can be used. */
   uint8_t buf[INTQ_BUFSIZE]; /**< Buffer. */
-  int head;                  /**< New data is written here. */
-  int tail;                  /**< Old data is read here. */
+  unsigned head;             /**< New data is written at this count. */
+  unsigned tail;             /**< Old data is read at this count. */
 };
 
 void intq_init(struct intq *);
@@ -38,5 +46,7 @@ bool intq_empty(const struct intq *);
 bool intq_full(const struct intq *);
 uint8_t intq_getc(struct intq *);
 void intq_putc(struct intq *, uint8_t);
+size_t intq_read(struct intq *, void *, size_t);
+size_t intq_write(struct intq *, const void *, size_t);
 
 #endif /**< devices/intq.h */
@@ -76,3 +76,23 @@ void pit_configure_channel(int channel, int mode, int frequency) {
   outb(PIT_PORT_COUNTER(channel), count >> 8);
   intr_set_level(old_level);
 }
+
+/** Arms channel 0 to interrupt once, NS nanoseconds from now, in
+   mode 0 ("interrupt on terminal count").  The delay is clamped
+   to what the 16-bit counter can express, about 838 ns to 55 ms.
+   Calling pit_configure_channel() on channel 0 returns it to
+   periodic operation. */
+void pit_oneshot(uint64_t ns) {
+  uint64_t count = ns * PIT_HZ / 1000000000;
+
+  if (count < 2)
+    count = 2;
+  else if (count > 0xffff)
+    count = 0xffff;
+
+  enum intr_level old_level = intr_disable();
+  outb(PIT_PORT_CONTROL, 0x30);
+  outb(PIT_PORT_COUNTER(0), count);
+  outb(PIT_PORT_COUNTER(0), count >> 8);
+  intr_set_level(old_level);
+}
@@ -4,5 +4,6 @@
 #include <stdint.h>
 
 void pit_configure_channel(int channel, int mode, int frequency);
+void pit_oneshot(uint64_t ns);
 
 #endif /**< devices/pit.h */
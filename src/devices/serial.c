@@ -39,6 +39,21 @@
 #define IER_RECV 0x01 /**< Interrupt when data received. */
 #define IER_XMIT 0x02 /**< Interrupt when transmit finishes. */
 
+/** Interrupt Identification Register bits. */
+#define IIR_FIFO 0xc0 /**< Both set if the FIFOs are enabled. */
+
+/** FIFO Control Register bits. */
+#define FCR_ENABLE 0x01   /**< Enable the transmit and receive FIFOs. */
+#define FCR_CLR_RECV 0x02 /**< Clear the receive FIFO. */
+#define FCR_CLR_XMIT 0x04 /**< Clear the transmit FIFO. */
+#define FCR_TRIG_1 0x00   /**< Receive interrupt at 1 byte in the FIFO. */
+#define FCR_TRIG_4 0x40   /**< ...at 4 bytes. */
+#define FCR_TRIG_8 0x80   /**< ...at 8 bytes. */
+#define FCR_TRIG_14 0xc0  /**< ...at 14 bytes. */
+
+/** Size of the 16550A's transmit FIFO, in bytes. */
+#define XMIT_FIFO_SIZE 16
+
 /** Line Control Register bits. */
 #define LCR_N81 0x03  /**< No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80 /**< Divisor Latch Access Bit (DLAB). */
@@ -53,11 +68,18 @@
 /** Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
+/** Bytes that may be written to THR each time it is found
+   empty: XMIT_FIFO_SIZE if the FIFOs are on, otherwise 1. */
+static int xmit_burst;
+
 /** Data to be transmitted. */
 static struct intq txq;
 
 static void set_serial(int bps);
+static void init_fifo(void);
 static void putc_poll(uint8_t);
+static void xmit_poll(void);
+static void xmit(void);
 static void write_ier(void);
 static intr_handler_func serial_interrupt;
 
@@ -68,7 +90,7 @@ static intr_handler_func serial_interrupt;
 static void init_poll(void) {
   ASSERT(mode == UNINIT);
   outb(IER_REG, 0);        /**< Turn off all interrupts. */
-  outb(FCR_REG, 0);        /**< Disable FIFO. */
+  init_fifo();             /**< Enable FIFOs, if present. */
   set_serial(9600);        /**< 9.6 kbps, N-8-1. */
   outb(MCR_REG, MCR_OUT2); /**< Required to enable interrupts. */
   intq_init(&txq);
@@ -107,7 +129,7 @@ void serial_putc(uint8_t byte) {
          we'd have to reenable interrupts.
          That's impolite, so we'll send a character via
          polling instead. */
-      putc_poll(intq_getc(&txq));
+      xmit_poll();
     }
 
     intq_putc(&txq, byte);
@@ -117,11 +139,55 @@ void serial_putc(uint8_t byte) {
   intr_set_level(old_level);
 }
 
+/** Sends the N bytes in BUFFER to the serial port, like
+   serial_putc() but updating the interrupt enable register only
+   when the transmit queue fills up and at the end. */
+void serial_putbuf(const char *buffer, size_t n) {
+  enum intr_level old_level = intr_disable();
+
+  if (mode != QUEUE) {
+    if (mode == UNINIT) init_poll();
+    while (n > 0) {
+      size_t chunk = n < (size_t)xmit_burst ? n : (size_t)xmit_burst;
+
+      /* Wait for THR to empty, then fill the FIFO. */
+      while ((inb(LSR_REG) & LSR_THRE) == 0) continue;
+      n -= chunk;
+      while (chunk-- > 0) outb(THR_REG, *buffer++);
+    }
+  } else if (old_level == INTR_ON) {
+    /* Let the transmit interrupt drain the queue while
+       intq_write() waits.  Enabling it first, whenever the queue
+       is not empty, ensures that it runs if intq_write() has to
+       wait; if the queue is empty, a queue's worth fits without
+       waiting. */
+    while (n > 0) {
+      size_t chunk = n < INTQ_BUFSIZE ? n : INTQ_BUFSIZE;
+
+      write_ier();
+      intq_write(&txq, buffer, chunk);
+      buffer += chunk;
+      n -= chunk;
+    }
+    write_ier();
+  } else {
+    /* Interrupts are off, so make room by polling, as
+       serial_putc() does. */
+    while (n-- > 0) {
+      if (intq_full(&txq)) xmit_poll();
+      intq_putc(&txq, *buffer++);
+    }
+    write_ier();
+  }
+
+  intr_set_level(old_level);
+}
+
 /** Flushes anything in the serial buffer out the port in polling
    mode. */
 void serial_flush(void) {
   enum intr_level old_level = intr_disable();
-  while (!intq_empty(&txq)) putc_poll(intq_getc(&txq));
+  while (!intq_empty(&txq)) xmit_poll();
   intr_set_level(old_level);
 }
 
@@ -152,6 +218,25 @@ static void set_serial(int bps) {
   outb(LCR_REG, LCR_N81);
 }
 
+/** Turns on the 16550A's FIFOs, clearing them, and sets
+   xmit_burst according to whether that worked.  An 8250 or 16450
+   has no FIFOs and ignores FCR; a 16550 without the "A" has
+   broken ones and reports them as such in IIR.
+
+   The receive trigger is set at 8 bytes: fewer interrupts than at
+   1 byte, yet 8 bytes of room remain for the time it takes to
+   respond.  Input that stops short of the trigger level is still
+   delivered, by the character timeout interrupt. */
+static void init_fifo(void) {
+  outb(FCR_REG, FCR_ENABLE | FCR_CLR_RECV | FCR_CLR_XMIT | FCR_TRIG_8);
+  if ((inb(IIR_REG) & IIR_FIFO) == IIR_FIFO)
+    xmit_burst = XMIT_FIFO_SIZE;
+  else {
+    outb(FCR_REG, 0);
+    xmit_burst = 1;
+  }
+}
+
 /** Update interrupt enable register. */
 static void write_ier(void) {
   ASSERT(intr_get_level() == INTR_OFF);
@@ -178,6 +263,28 @@ static void putc_poll(uint8_t byte) {
   outb(THR_REG, byte);
 }
 
+/** Moves bytes from the transmit queue to the hardware, if THR is
+   empty: up to a full FIFO's worth, since THRE means the whole
+   transmit FIFO has drained. */
+static void xmit(void) {
+  uint8_t burst[XMIT_FIFO_SIZE];
+  size_t i, n;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if ((inb(LSR_REG) & LSR_THRE) == 0 || intq_empty(&txq)) return;
+  n = intq_read(&txq, burst, xmit_burst);
+  for (i = 0; i < n; i++) outb(THR_REG, burst[i]);
+}
+
+/** Polls the serial port until it's ready, and then transmits as
+   much of the transmit queue as it will take. */
+static void xmit_poll(void) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  while ((inb(LSR_REG) & LSR_THRE) == 0) continue;
+  xmit();
+}
+
 /** Serial interrupt handler. */
 static void serial_interrupt(struct intr_frame *f UNUSED) {
   /* Inquire about interrupt in UART.  Without this, we can
@@ -188,9 +295,9 @@ static void serial_interrupt(struct intr_frame *f UNUSED) {
      has a byte for us, receive a byte.  */
   while (!input_full() && (inb(LSR_REG) & LSR_DR) != 0) input_putc(inb(RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty(&txq) && (inb(LSR_REG) & LSR_THRE) != 0) outb(THR_REG, intq_getc(&txq));
+  /* If the hardware is ready to accept bytes for transmission,
+     refill its FIFO from the queue. */
+  xmit();
 
   /* Update interrupt enable register based on queue status. */
   write_ier();
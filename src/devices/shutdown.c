@@ -8,6 +8,8 @@
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
@@ -49,6 +51,7 @@ void shutdown_configure(enum shutdown_type type) { how = type; }
 
 /** Reboots the machine via the keyboard controller. */
 void shutdown_reboot(void) {
+  console_flush();
   printf("Rebooting...\n");
 
   /* See [kbd] for details on how to program the keyboard
@@ -81,6 +84,10 @@ void shutdown_power_off(void) {
 #ifdef FILESYS
   filesys_done();
 #endif
+  trace_dump();
+
+  /* Write out buffered output, then print the rest directly. */
+  console_flush();
 
   // Timer: 866 ticks
   // Thread: 839 idle ticks, 27 kernel ticks, 0 user ticks
@@ -119,6 +126,7 @@ void shutdown_power_off(void) {
 static void print_stats(void) {
   timer_print_stats();
   thread_print_stats();
+  workqueue_print_stats();
 #ifdef FILESYS
   block_print_stats();
 #endif
@@ -2,6 +2,7 @@
 
 #include <debug.h>
 #include <inttypes.h>
+#include <rbtree.h>
 #include <round.h>
 #include <stdio.h>
 #include <string.h>
@@ -10,9 +11,11 @@
 #include "fixed1714.h"
 #include "formula.h"
 #include "kernel/list.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 
 /** See [8254] for hardware details of the 8254 timer chip. */
 
@@ -30,11 +33,58 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/** Nanoseconds per timer tick. */
+#define NS_PER_TICK (1000000000 / TIMER_FREQ)
+
+/** Timer ticks over which timer_calibrate() measures the
+   time-stamp counter. */
+#define TSC_CALIBRATE_TICKS 4
+
+/** timer_now_ns() converts time-stamp counter cycles to
+   nanoseconds by multiplying by tsc_mult / 2**TSC_SHIFT. */
+#define TSC_SHIFT 24
+
+/** Time-stamp counter frequency in Hz, or 0 until
+   timer_calibrate() has measured it. */
+static uint64_t tsc_hz;
+static uint32_t tsc_mult; /**< Nanoseconds per cycle, times 2**TSC_SHIFT. */
+static uint64_t tsc_base; /**< Counter value at NS_BASE. */
+static int64_t ns_base;   /**< timer_now_ns() at TSC_BASE. */
+
+/** Sleepers waiting for a deadline finer than a tick. */
+struct hr_sleep_elem {
+  struct rb_node node;    /**< Node in hr_sleepers. */
+  int64_t deadline;       /**< timer_now_ns() value to wake at. */
+  struct semaphore sema;  /**< Upped at DEADLINE. */
+};
+
+/** High-resolution sleepers, soonest deadline first.  Protected by
+   disabling interrupts, since the timer interrupt wakes them. */
+static struct rb_tree hr_sleepers;
+
+/** While high-resolution sleepers are waiting, channel 0 of the
+   PIT runs in one-shot mode, armed for whichever comes first: the
+   next tick or the next sleeper's deadline.  Ticks are then kept
+   on schedule by the time-stamp counter.  Otherwise it runs in
+   the usual periodic mode. */
+static bool oneshot;
+
+/** timer_now_ns() at the latest tick. */
+static int64_t last_tick_ns;
+
+/** Timer interrupts within this many nanoseconds of a deadline
+   count as on time, since the PIT's resolution is about 838 ns. */
+#define TIMER_SLACK_NS 2000
+
 static intr_handler_func timer_interrupt;
+static void timer_tick(void);
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
 static void real_time_delay(int64_t num, int32_t denom);
+static void hr_sleep(int64_t deadline);
+static rb_less_func hr_sleep_less;
+static void hr_program(bool at_tick);
 
 static struct lock timer_sleep_lock;
 static struct list timer_sleep_list;
@@ -55,6 +105,7 @@ void timer_init(void) {
   intr_register_ext(0x20, timer_interrupt, "8254 Timer");
   lock_init(&timer_sleep_lock);
   list_init(&timer_sleep_list);
+  rb_init(&hr_sleepers, hr_sleep_less, NULL, NULL);
 }
 
 /** Calibrates(标准) loops_per_tick, used to implement brief delays. */
@@ -77,6 +128,21 @@ void timer_calibrate(void) {
   }
 
   printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+
+  /* Count time-stamp counter cycles over a few whole ticks. */
+  int64_t start = ticks;
+  while (ticks == start) barrier();
+  start = ticks;
+  uint64_t tsc0 = rdtsc();
+  while (ticks - start < TSC_CALIBRATE_TICKS) barrier();
+  uint64_t tsc1 = rdtsc();
+
+  enum intr_level old_level = intr_disable();
+  tsc_base = tsc1;
+  ns_base = last_tick_ns = (start + TSC_CALIBRATE_TICKS) * NS_PER_TICK;
+  tsc_mult = ((uint64_t)1000000000 << TSC_SHIFT) * TSC_CALIBRATE_TICKS / ((tsc1 - tsc0) * TIMER_FREQ);
+  tsc_hz = (tsc1 - tsc0) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+  intr_set_level(old_level);
 }
 
 /** Returns the number of timer ticks since the OS booted. */
@@ -91,6 +157,24 @@ int64_t timer_ticks(void) {
    should be a value once returned by timer_ticks(). */
 int64_t timer_elapsed(int64_t then) { return timer_ticks() - then; }
 
+/** Returns the number of nanoseconds since the OS booted, as
+   measured by the time-stamp counter.  Before timer_calibrate(),
+   only tick resolution is available. */
+int64_t timer_now_ns(void) {
+  if (tsc_hz == 0) return timer_ticks() * NS_PER_TICK;
+
+  /* Split the 64-bit cycle count so that each product fits in
+     64 bits. */
+  uint64_t delta = rdtsc() - tsc_base;
+  uint64_t lo = ((uint64_t)(uint32_t)delta * tsc_mult) >> TSC_SHIFT;
+  uint64_t hi = ((delta >> 32) * tsc_mult) << (32 - TSC_SHIFT);
+  return ns_base + (int64_t)(hi + lo);
+}
+
+/** Returns the time-stamp counter's frequency in Hz, or 0 if it
+   has not been measured yet. */
+uint64_t timer_tsc_hz(void) { return tsc_hz; }
+
 /* ---------- ---------- sleep ---------- ---------- */
 
 /** Sleeps for approximately TICKS timer ticks.  Interrupts must
@@ -109,7 +193,9 @@ void timer_sleep(int64_t ticks) {
   list_push_back(&timer_sleep_list, &tse.elem);
   lock_release(&timer_sleep_lock);
 
+  enum thread_wait old_wait = thread_set_wait(WAIT_SLEEP);
   sema_down(&tse.sema);
+  thread_set_wait(old_wait);
 
   //   while (timer_elapsed(start) < ticks) thread_yield();
 }
@@ -155,6 +241,70 @@ void timer_udelay(int64_t us) { real_time_delay(us, 1000 * 1000); }
    instead if interrupts are enabled.*/
 void timer_ndelay(int64_t ns) { real_time_delay(ns, 1000 * 1000 * 1000); }
 
+/** Sleeps until timer_now_ns() reaches DEADLINE, with the timer
+   armed to interrupt at DEADLINE rather than at the next tick. */
+static void hr_sleep(int64_t deadline) {
+  struct hr_sleep_elem hse;
+
+  ASSERT(intr_get_level() == INTR_ON);
+
+  /* Not worth programming the PIT for. */
+  if (deadline - timer_now_ns() <= TIMER_SLACK_NS) {
+    while (timer_now_ns() < deadline) barrier();
+    return;
+  }
+
+  hse.deadline = deadline;
+  sema_init(&hse.sema, 0);
+
+  enum intr_level old_level = intr_disable();
+  rb_insert(&hr_sleepers, &hse.node);
+  hr_program(false);
+  enum thread_wait old_wait = thread_set_wait(WAIT_SLEEP);
+  sema_down(&hse.sema);
+  thread_set_wait(old_wait);
+  intr_set_level(old_level);
+}
+
+/** Orders hr_sleep_elems by deadline. */
+static bool hr_sleep_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct hr_sleep_elem, node)->deadline < rb_entry(b, struct hr_sleep_elem, node)->deadline;
+}
+
+/** Wakes the high-resolution sleepers whose deadlines have come. */
+static void hr_wake(int64_t now) {
+  while (!rb_empty(&hr_sleepers)) {
+    struct hr_sleep_elem *hse = rb_entry(rb_first(&hr_sleepers), struct hr_sleep_elem, node);
+    if (hse->deadline > now + TIMER_SLACK_NS) break;
+    rb_remove(&hr_sleepers, &hse->node);
+    sema_up_intr(&hse->sema);
+  }
+}
+
+/** Programs channel 0 for the next event after a change to
+   hr_sleepers or a timer interrupt.  AT_TICK is true if this is
+   at a tick, the only time periodic mode can be resumed in phase
+   with the ticks so far. */
+static void hr_program(bool at_tick) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (rb_empty(&hr_sleepers) && (!oneshot || at_tick)) {
+    if (oneshot) pit_configure_channel(0, 2, TIMER_FREQ);
+    oneshot = false;
+    return;
+  }
+
+  int64_t target = last_tick_ns + NS_PER_TICK;
+  if (!rb_empty(&hr_sleepers)) {
+    struct hr_sleep_elem *hse = rb_entry(rb_first(&hr_sleepers), struct hr_sleep_elem, node);
+    if (hse->deadline < target) target = hse->deadline;
+  }
+
+  int64_t now = timer_now_ns();
+  oneshot = true;
+  pit_oneshot(target > now ? target - now : 0);
+}
+
 /** Prints timer statistics. */
 void timer_print_stats(void) { printf("Timer: %" PRId64 " ticks\n", timer_ticks()); }
 
@@ -208,10 +358,29 @@ static void priority_tick(void) {
   }
 }
 
-/** Timer interrupt handler. */
+/** Timer interrupt handler.  In one-shot mode, not every
+   interrupt is a tick. */
 static void timer_interrupt(struct intr_frame *args UNUSED) {
+  int64_t now = timer_now_ns();
+  bool tick = !oneshot || now + TIMER_SLACK_NS >= last_tick_ns + NS_PER_TICK;
+
+  if (tick) {
+    /* Keep ticks on the schedule set by the PIT in periodic
+       mode. */
+    last_tick_ns = oneshot ? last_tick_ns + NS_PER_TICK : now;
+    timer_tick();
+  }
+  if (tsc_hz != 0) {
+    hr_wake(now);
+    hr_program(tick);
+  }
+}
+
+/** Does the work of a timer tick. */
+static void timer_tick(void) {
   ticks++;
   timer_sleep_tick();
+  workqueue_tick(ticks);
   thread_tick();
   if (thread_mlfqs()) {
     load_avg_tick();
@@ -248,8 +417,21 @@ static void NO_INLINE busy_wait(int64_t loops) {
   while (loops-- > 0) barrier();
 }
 
-/** Sleep for approximately NUM/DENOM seconds. */
+/** Sleep for approximately NUM/DENOM seconds.  DENOM must divide
+   1,000,000,000.  Once the time-stamp counter is calibrated,
+   whole ticks are slept with timer_sleep() and the rest with a
+   one-shot timer; before then, sub-tick sleeps busy-wait. */
 static void real_time_sleep(int64_t num, int32_t denom) {
+  if (tsc_hz != 0) {
+    int64_t ns = num * (1000000000 / denom);
+    int64_t deadline = timer_now_ns() + ns;
+
+    ASSERT(intr_get_level() == INTR_ON);
+    if (ns / NS_PER_TICK > 1) timer_sleep(ns / NS_PER_TICK - 1);
+    hr_sleep(deadline);
+    return;
+  }
+
   /* Convert NUM/DENOM seconds into timer ticks, rounding down.
 
         (NUM / DENOM) s
@@ -12,6 +12,8 @@ void timer_calibrate(void);
 
 int64_t timer_ticks(void);
 int64_t timer_elapsed(int64_t);
+int64_t timer_now_ns(void);
+uint64_t timer_tsc_hz(void);
 
 /** Sleep and yield the CPU to other threads. */
 void timer_sleep(int64_t ticks);
@@ -52,6 +52,57 @@ static inline elem_type last_mask(const struct bitmap *b) {  // 返回一个 bit
   return last_bits ? ((elem_type)1 << last_bits) - 1 : (elem_type)-1;
 }
 
+/** Returns a mask of the bits of element IDX that represent bits
+   START through END - 1 of the bitmap.  IDX must lie between
+   elem_idx(START) and elem_idx(END - 1), inclusive. */
+static inline elem_type range_mask(size_t idx, size_t start, size_t end) {
+  size_t base = idx * ELEM_BITS;
+  elem_type mask = (elem_type)-1;
+  if (start > base) mask &= (elem_type)-1 << (start - base);
+  if (end < base + ELEM_BITS) mask &= ((elem_type)1 << (end - base)) - 1;
+  return mask;
+}
+
+/** Returns element IDX of B's bits, inverted if VALUE is false,
+   so that its 1 bits are exactly the bits set to VALUE. */
+static inline elem_type elem_match(const struct bitmap *b, size_t idx, bool value) {
+  return value ? b->bits[idx] : ~b->bits[idx];
+}
+
+/** Returns the number of 1 bits in X.  The kernel is not linked
+   against libgcc and the 80x86 baseline has no POPCNT, so this
+   sums bits in parallel within the word instead of calling
+   __builtin_popcountl(). */
+static inline size_t elem_popcount(elem_type x) {
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0f0f0f0f;
+  return (x * 0x01010101) >> 24;
+}
+
+/** Returns the index of the first bit in B between START and END,
+   exclusive, that is set to VALUE, or END if there is none.
+   Examines a whole element at a time, skipping elements with no
+   matching bit and locating the match within the first element
+   that has one with BSF. */
+static size_t find_next(const struct bitmap *b, size_t start, size_t end, bool value) {
+  size_t idx, last;
+  elem_type match;
+
+  if (start >= end) return end;
+
+  idx = elem_idx(start);
+  last = elem_idx(end - 1);
+  match = elem_match(b, idx, value) & range_mask(idx, start, end);
+  while (match == 0) {
+    if (++idx > last) return end;
+    match = elem_match(b, idx, value);
+  }
+
+  start = idx * ELEM_BITS + __builtin_ctzl(match);
+  return start < end ? start : end;
+}
+
 /** Creation and destruction. */
 
 /** Creates and returns a pointer to a newly allocated bitmap with room for
@@ -169,30 +220,46 @@ void bitmap_set_all(struct bitmap *b, bool value) {
   bitmap_set_multiple(b, 0, bitmap_size(b), value);
 }
 
-/** Sets the CNT bits starting at START in B to VALUE. */
+/** Sets the CNT bits starting at START in B to VALUE.
+   Each element of B's bits is updated atomically. */
 void bitmap_set_multiple(struct bitmap *b, size_t start, size_t cnt, bool value) {
   ASSERT(b != NULL);
   ASSERT(start <= b->bit_cnt);
   ASSERT(start + cnt <= b->bit_cnt);
 
-  for (size_t i = 0; i < cnt; i++) {
-    bitmap_set(b, start + i, value);  // set bitmap[start : start + i)
+  if (cnt == 0) return;
+
+  size_t end = start + cnt;
+  for (size_t idx = elem_idx(start); idx <= elem_idx(end - 1); idx++) {
+    elem_type mask = range_mask(idx, start, end);
+
+    /* Atomic on a uniprocessor, as in bitmap_mark() and
+       bitmap_reset(). */
+    if (value) {
+      asm("orl %1, %0" : "=m"(b->bits[idx]) : "r"(mask) : "cc");
+    } else {
+      asm("andl %1, %0" : "=m"(b->bits[idx]) : "r"(~mask) : "cc");
+    }
   }
 }
 
 /** Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t bitmap_count(const struct bitmap *b, size_t start, size_t cnt, bool value) {
-  size_t i, value_cnt;
+  size_t end, idx, value_cnt;
 
   ASSERT(b != NULL);
   ASSERT(start <= b->bit_cnt);
   ASSERT(start + cnt <= b->bit_cnt);
 
+  if (cnt == 0) return 0;
+
+  end = start + cnt;
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test(b, start + i) == value) value_cnt++;
-  return value_cnt;
+  for (idx = elem_idx(start); idx <= elem_idx(end - 1); idx++) {
+    value_cnt += elem_popcount(b->bits[idx] & range_mask(idx, start, end));
+  }
+  return value ? value_cnt : cnt - value_cnt;
 }
 
 /** Returns true if any bits in B between START and START + CNT,
@@ -203,12 +270,7 @@ bool bitmap_contains(const struct bitmap *b, size_t start, size_t cnt, bool valu
   ASSERT(start <= b->bit_cnt);
   ASSERT(start + cnt <= b->bit_cnt);
 
-  for (size_t i = 0; i < cnt; i++) {
-    if (bitmap_test(b, start + i) == value) {
-      return true;
-    }
-  }
-  return false;
+  return find_next(b, start, start + cnt, value) < start + cnt;
 }
 
 /** Returns true if any bits in B between START and START + CNT,
@@ -233,19 +295,23 @@ size_t bitmap_scan(const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT(b != NULL);
   ASSERT(start <= b->bit_cnt);
 
+  if (cnt == 0) return start;
+
   // cnt: 待分配的数量, 待分配的数量 must <= bitmap 总数量
   if (cnt <= b->bit_cnt) {
     size_t last = b->bit_cnt - cnt;
-    for (size_t i = start; i <= last; i++) {
-      // 比方说: value = 1 , !value = 0
-      // not 0 in bitmap[i : i+cnt) => bitmap[i : i+cnt) 全是 1
-      // 如果 bitmap[i : i+cnt) 全是 1, 那么返回 i
-      //
-      // NOTE: 因此 bitmap_scan 的返回值是:
-      // 找到: 从 start 开始, 长度为 cnt 的连续为 value 的起始 index
-      if (!bitmap_contains(b, i, cnt, !value)) {
-        return i;
-      }
+    size_t i = start;
+    while (i <= last) {
+      /* Skip ahead to the next bit set to VALUE, which is the
+         earliest place a run can begin.  If the CNT bits from there
+         are not all VALUE, no run can begin at or before the first
+         bit that is !VALUE, so resume just past it. */
+      size_t run = find_next(b, i, last + 1, value);
+      if (run > last) break;
+
+      size_t bad = find_next(b, run, run + cnt, !value);
+      if (bad == run + cnt) return run;
+      i = bad + 1;
     }
   }
 
@@ -1,15 +1,106 @@
 #include <console.h>
+#include <round.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 
-static void vprintf_helper(char, void *);
+/** Asynchronous console output.
+
+   Once console_init_async() has been called, output does not go
+   straight to the devices.  Each printf(), puts() or putbuf()
+   call instead copies its text into a ring of fixed-size slots
+   and returns.  The "console" thread drains the ring in batches,
+   handing each batch to the serial driver's transmit queue and
+   the VGA framebuffer in one call, so that the VGA cursor and the
+   UART interrupt enable register are updated once per batch
+   rather than once per character.
+
+   Threads and interrupt handlers both write to the ring, so, like
+   other data shared with interrupt handlers, it is protected by
+   turning interrupts off.  A producer checks for room, copies its
+   text into a run of consecutive slots and advances `ring_head'
+   all with interrupts off, and a consumer copies slots out and
+   advances `ring_tail' the same way.  Copying is cheap next to
+   the device output, which happens with interrupts on.  Threads
+   that drain the ring are serialized by `flush_lock'.
+
+   If the ring is full, a thread drains it itself, which keeps
+   the output in order.  An interrupt handler cannot wait for
+   that, and neither can the thread that is draining, so their
+   text is dropped and counted.
+
+   The text of one console_write() lands in consecutive slots, so
+   it is not interleaved with other output.  vprintf() writes its
+   output whenever its buffer of SLOT_DATA bytes fills, and
+   putbuf() splits text longer than SLOT_RUN_MAX slots, so longer
+   output from one call may be interleaved with output from
+   another.
+
+   Before console_init_async(), after console_flush(), and once a
+   kernel panic is underway, output is written synchronously as
+   before, under the console lock.  An interrupt handler that
+   calls console_flush(), or a panic, writes out what is in the
+   ring first, but only if no thread holds `flush_lock': that
+   thread may be partway through a drain of its own. */
+
+/** Bytes of text in one ring slot. */
+#define SLOT_DATA 120
+
+/** Number of slots in the ring.  Must be a power of 2. */
+#define SLOT_CNT 128
+
+/** Most slots claimed by a single call.  Longer text is split. */
+#define SLOT_RUN_MAX (SLOT_CNT / 4)
+
+/** A slot in the ring. */
+struct slot {
+  uint32_t len;         /**< Bytes used in DATA. */
+  char data[SLOT_DATA]; /**< Text. */
+};
+
+/** The ring.  Protected by disabling interrupts. */
+static struct slot ring[SLOT_CNT];
+static uint32_t ring_head; /**< Next position to fill. */
+static uint32_t ring_tail; /**< Next position to drain. */
+static int64_t drop_cnt;   /**< Characters dropped because the ring was full. */
+
+/** True while output goes through the ring. */
+static volatile bool async;
+
+/** Serializes consumers of the ring. */
+static struct lock flush_lock;
+
+/** The flusher thread, and whether it is blocked waiting for
+   output.  Protected by disabling interrupts.  It is woken with
+   thread_unblock() rather than a semaphore so that printing never
+   yields the CPU, which would change the schedule of the thread
+   doing the printing. */
+static struct thread *flusher_thread;
+static bool flusher_waiting;
+static bool flush_pending;
+
+/** vprintf() state. */
+struct vprintf_aux {
+  int char_cnt;         /**< Characters formatted so far. */
+  size_t len;           /**< Characters in BUF. */
+  char buf[SLOT_DATA];  /**< Line buffer, in asynchronous mode. */
+};
+
+static void vprintf_helper(const char *, size_t, void *);
 static void putchar_have_lock(uint8_t c);
+static void emit(const char *, size_t);
+static void console_write(const char *, size_t);
+static thread_func flusher NO_RETURN;
+static void drain(char *batch, size_t size);
+static void drain_unlocked(void);
+static void wake_flusher(void);
 
 /** The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -66,13 +157,46 @@ void console_init(void) {
   use_console_lock = true;
 }
 
+/** Starts the flusher thread and switches console output to the
+   ring.  Must be called after the thread system and the serial
+   transmit queue are up. */
+void console_init_async(void) {
+  lock_init(&flush_lock);
+  thread_create("console", PRI_MIN, flusher, NULL);
+  async = true;
+}
+
+/** Writes out everything in the ring and returns to synchronous
+   output.  Called before powering off or rebooting, possibly from
+   an interrupt handler. */
+void console_flush(void) {
+  if (!async) return;
+  if (intr_context()) {
+    async = false;
+    drain_unlocked();
+    return;
+  }
+
+  lock_acquire(&flush_lock);
+  async = false;
+  drain(NULL, 0);
+  lock_release(&flush_lock);
+}
+
 /** Notifies the console that a kernel panic is underway,
    which warns it to avoid trying to take the console lock from
-   now on. */
-void console_panic(void) { use_console_lock = false; }
+   now on.  Whatever is in the ring is written out first, unless
+   a thread, possibly the one that panicked, is draining it. */
+void console_panic(void) {
+  use_console_lock = false;
+  if (async) {
+    async = false;
+    drain_unlocked();
+  }
+}
 
 /** Prints console statistics. */
-void console_print_stats(void) { printf("Console: %lld characters output\n", write_cnt); }
+void console_print_stats(void) { printf("Console: %lld characters output, %lld dropped\n", write_cnt, drop_cnt); }
 
 /** Acquires the console lock. */
 static void acquire_console(void) {
@@ -102,20 +226,33 @@ static bool console_locked_by_current_thread(void) { return (intr_context() || !
    which is like printf() but uses a va_list.
    Writes its output to both vga display and serial port. */
 int vprintf(const char *format, va_list args) {
-  int char_cnt = 0;
+  struct vprintf_aux aux;
 
-  acquire_console();
-  __vprintf(format, args, vprintf_helper, &char_cnt);
-  release_console();
+  aux.len = aux.char_cnt = 0;
+  if (async) {
+    /* Format into a line buffer, writing it to the ring whenever
+       it fills up. */
+    __vprintf(format, args, vprintf_helper, &aux);
+    console_write(aux.buf, aux.len);
+  } else {
+    acquire_console();
+    __vprintf(format, args, vprintf_helper, &aux);
+    release_console();
+  }
 
-  return char_cnt;
+  return aux.char_cnt;
 }
 
 /** Writes string S to the console, followed by a new-line
    character. */
 int puts(const char *s) {
+  if (async) {
+    printf("%s\n", s);
+    return 0;
+  }
+
   acquire_console();
-  while (*s != '\0') putchar_have_lock(*s++);
+  emit(s, strlen(s));
   putchar_have_lock('\n');
   release_console();
 
@@ -124,13 +261,25 @@ int puts(const char *s) {
 
 /** Writes the N characters in BUFFER to the console. */
 void putbuf(const char *buffer, size_t n) {
+  if (async) {
+    console_write(buffer, n);
+    return;
+  }
+
   acquire_console();
-  while (n-- > 0) putchar_have_lock(*buffer++);
+  emit(buffer, n);
   release_console();
 }
 
 /** Writes C to the vga display and serial port. */
 int putchar(int c) {
+  char ch = c;
+
+  if (async) {
+    console_write(&ch, 1);
+    return c;
+  }
+
   acquire_console();
   putchar_have_lock(c);
   release_console();
@@ -138,11 +287,31 @@ int putchar(int c) {
   return c;
 }
 
-/** Helper function for vprintf(). */
-static void vprintf_helper(char c, void *char_cnt_) {
-  int *char_cnt = char_cnt_;
-  (*char_cnt)++;
-  putchar_have_lock(c);
+/** Helper function for vprintf().  Writes the N characters in
+   S, a span of vprintf()'s output. */
+static void vprintf_helper(const char *s, size_t n, void *aux_) {
+  struct vprintf_aux *aux = aux_;
+
+  aux->char_cnt += n;
+  if (!async) {
+    ASSERT(console_locked_by_current_thread());
+    emit(s, n);
+    return;
+  }
+
+  while (n > 0) {
+    size_t chunk = sizeof aux->buf - aux->len;
+
+    if (chunk > n) chunk = n;
+    memcpy(aux->buf + aux->len, s, chunk);
+    aux->len += chunk;
+    s += chunk;
+    n -= chunk;
+    if (aux->len == sizeof aux->buf) {
+      console_write(aux->buf, aux->len);
+      aux->len = 0;
+    }
+  }
 }
 
 /** Writes C to the vga display and serial port.
@@ -154,3 +323,139 @@ static void putchar_have_lock(uint8_t c) {
   serial_putc(c);
   vga_putc(c);
 }
+
+/** Writes the N bytes in BUFFER to both devices.  The console
+   lock, or `flush_lock', is held, or a panic is underway. */
+static void emit(const char *buffer, size_t n) {
+  write_cnt += n;
+  serial_putbuf(buffer, n);
+  vga_putbuf(buffer, n);
+}
+
+/** Copies the N bytes in BUFFER into the ring, as one run of
+   slots, and returns true, or returns false if the ring is too
+   full. */
+static bool ring_put(const char *buffer, size_t n) {
+  uint32_t cnt = DIV_ROUND_UP(n, SLOT_DATA);
+  enum intr_level old_level;
+  bool fits;
+
+  ASSERT(cnt <= SLOT_RUN_MAX);
+  old_level = intr_disable();
+  fits = ring_head - ring_tail + cnt <= SLOT_CNT;
+  if (fits)
+    while (cnt-- > 0) {
+      struct slot *s = &ring[ring_head++ & (SLOT_CNT - 1)];
+
+      s->len = n < SLOT_DATA ? n : SLOT_DATA;
+      memcpy(s->data, buffer, s->len);
+      buffer += s->len;
+      n -= s->len;
+    }
+  intr_set_level(old_level);
+  return fits;
+}
+
+/** Writes the N bytes in BUFFER to the console through the ring. */
+static void console_write(const char *buffer, size_t n) {
+  while (n > 0) {
+    size_t chunk = n < SLOT_RUN_MAX * SLOT_DATA ? n : SLOT_RUN_MAX * SLOT_DATA;
+
+    while (!ring_put(buffer, chunk)) {
+      /* The ring is full.  A thread drains it itself, which also
+         keeps the output in order.  An interrupt handler cannot
+         wait, and the thread that holds `flush_lock' would wait
+         for itself, so their text is dropped. */
+      if (intr_context() || lock_held_by_current_thread(&flush_lock)) {
+        enum intr_level old_level = intr_disable();
+        drop_cnt += chunk;
+        intr_set_level(old_level);
+        break;
+      }
+      lock_acquire(&flush_lock);
+      drain(NULL, 0);
+      lock_release(&flush_lock);
+    }
+    buffer += chunk;
+    n -= chunk;
+  }
+
+  wake_flusher();
+}
+
+/** Tells the flusher thread there is output in the ring. */
+static void wake_flusher(void) {
+  enum intr_level old_level = intr_disable();
+
+  flush_pending = true;
+  if (flusher_waiting) {
+    flusher_waiting = false;
+    thread_unblock(flusher_thread);
+  }
+  intr_set_level(old_level);
+}
+
+/** Writes out the slots at the tail of the ring, in batches of
+   up to SIZE bytes gathered in BATCH.  If BATCH is null, uses a
+   static batch buffer that only holders of `flush_lock' may
+   use. */
+static void drain(char *batch, size_t size) {
+  static char flush_batch[SLOT_DATA * 8];
+
+  if (batch == NULL) {
+    ASSERT(lock_held_by_current_thread(&flush_lock));
+    batch = flush_batch;
+    size = sizeof flush_batch;
+  }
+
+  for (;;) {
+    enum intr_level old_level = intr_disable();
+    size_t len = 0;
+
+    while (ring_tail != ring_head) {
+      struct slot *s = &ring[ring_tail & (SLOT_CNT - 1)];
+
+      if (s->len > size - len) break;
+      memcpy(batch + len, s->data, s->len);
+      len += s->len;
+      ring_tail++;
+    }
+    intr_set_level(old_level);
+
+    if (len == 0) break;
+    emit(batch, len);
+  }
+}
+
+/** Drains the ring without taking `flush_lock', for an interrupt
+   handler or a panic, which cannot block.  Does nothing if a
+   thread holds `flush_lock', since it may be in the middle of
+   drain(). */
+static void drain_unlocked(void) {
+  char batch[SLOT_DATA];
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (flush_lock.holder == NULL) drain(batch, sizeof batch);
+}
+
+/** The "console" thread.  Drains the ring whenever there is
+   something in it.  It runs at PRI_MIN, so output is written out
+   when the CPU would otherwise go idle, or by a producer that
+   finds the ring full. */
+static void flusher(void *aux UNUSED) {
+  flusher_thread = thread_current();
+  for (;;) {
+    enum intr_level old_level = intr_disable();
+
+    if (!flush_pending) {
+      flusher_waiting = true;
+      thread_block();
+    }
+    flush_pending = false;
+    intr_set_level(old_level);
+
+    lock_acquire(&flush_lock);
+    drain(NULL, 0);
+    lock_release(&flush_lock);
+  }
+}
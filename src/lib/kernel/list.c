@@ -1,3 +1,6 @@
+/* Instantiates the accessors defined in list.h, unless they are
+   inlined there. */
+#define LIST_INSTANTIATE
 #include "list.h"
 
 #include "../debug.h"
@@ -53,85 +56,6 @@ void list_init(struct list *list) {
   list->tail.next = NULL;
 }
 
-/** Returns the beginning of LIST.  */
-struct list_elem *list_begin(struct list *list) {
-  ASSERT(list != NULL);
-  return list->head.next;
-}
-
-/** Returns the element after ELEM in its list.  If ELEM is the
-   last element in its list, returns the list tail.  Results are
-   undefined if ELEM is itself a list tail. */
-struct list_elem *list_next(struct list_elem *elem) {
-  ASSERT(is_head(elem) || is_interior(elem));
-  return elem->next;
-}
-
-/** Returns LIST's tail.
-
-   list_end() is often used in iterating through a list from
-   front to back.  See the big comment at the top of list.h for
-   an example. */
-struct list_elem *list_end(struct list *list) {
-  ASSERT(list != NULL);
-  return &list->tail;
-}
-
-/** Returns the LIST's reverse beginning, for iterating through
-   LIST in reverse order, from back to front. */
-struct list_elem *list_rbegin(struct list *list) {
-  ASSERT(list != NULL);
-  return list->tail.prev;
-}
-
-/** Returns the element before ELEM in its list.  If ELEM is the
-   first element in its list, returns the list head.  Results are
-   undefined if ELEM is itself a list head. */
-struct list_elem *list_prev(struct list_elem *elem) {
-  ASSERT(is_interior(elem) || is_tail(elem));
-  return elem->prev;
-}
-
-/** Returns LIST's head.
-
-   list_rend() is often used in iterating through a list in
-   reverse order, from back to front.  Here's typical usage,
-   following the example from the top of list.h:
-
-      for (e = list_rbegin (&foo_list); e != list_rend (&foo_list);
-           e = list_prev (e))
-        {
-          struct foo *f = container_of (e, struct foo, elem);
-          ...do something with f...
-        }
-*/
-struct list_elem *list_rend(struct list *list) {
-  ASSERT(list != NULL);
-  return &list->head;
-}
-
-/** Return's LIST's head.
-
-   list_head() can be used for an alternate style of iterating
-   through a list, e.g.:
-
-      e = list_head (&list);
-      while ((e = list_next (e)) != list_end (&list))
-        {
-          ...
-        }
-*/
-struct list_elem *list_head(struct list *list) {
-  ASSERT(list != NULL);
-  return &list->head;
-}
-
-/** Return's LIST's tail. */
-struct list_elem *list_tail(struct list *list) {
-  ASSERT(list != NULL);
-  return &list->tail;
-}
-
 /** Inserts ELEM just before BEFORE, which may be either an
    interior element or a tail.  The latter case is equivalent to
    list_push_back(). */
@@ -224,20 +148,6 @@ struct list_elem *list_pop_back(struct list *list) {
   return back;
 }
 
-/** Returns the front element in LIST.
-   Undefined behavior if LIST is empty. */
-struct list_elem *list_front(struct list *list) {
-  ASSERT(!list_empty(list));
-  return list->head.next;
-}
-
-/** Returns the back element in LIST.
-   Undefined behavior if LIST is empty. */
-struct list_elem *list_back(struct list *list) {
-  ASSERT(!list_empty(list));
-  return list->tail.prev;
-}
-
 /** Returns the number of elements in LIST.
    Runs in O(n) in the number of elements. */
 size_t list_size(struct list *list) {
@@ -248,9 +158,6 @@ size_t list_size(struct list *list) {
   return cnt;
 }
 
-/** Returns true if LIST is empty, false otherwise. */
-bool list_empty(struct list *list) { return list_begin(list) == list_end(list); }
-
 /** Swaps the `struct list_elem *'s that A and B point to. */
 static void swap(struct list_elem **a, struct list_elem **b) {
   struct list_elem *t = *a;
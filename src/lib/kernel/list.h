@@ -120,19 +120,31 @@ struct list {
     {NULL, &(NAME).tail}, { &(NAME).head, NULL } \
   }
 
+/** With LIST_INLINE, which the release profile defines (see
+   Make.config), the accessors marked LIST_ACCESSOR are static
+   inline functions, so that a traversal compiles down to plain
+   loads.  Otherwise list.c instantiates the same definitions, at
+   the end of this file, as ordinary functions that a debugger can
+   break on. */
+#ifdef LIST_INLINE
+#define LIST_ACCESSOR static inline
+#else
+#define LIST_ACCESSOR
+#endif
+
 void list_init(struct list *);
 
 /** List traversal. */
-struct list_elem *list_begin(struct list *);
-struct list_elem *list_next(struct list_elem *);
-struct list_elem *list_end(struct list *);
+LIST_ACCESSOR struct list_elem *list_begin(struct list *);
+LIST_ACCESSOR struct list_elem *list_next(struct list_elem *);
+LIST_ACCESSOR struct list_elem *list_end(struct list *);
 
-struct list_elem *list_rbegin(struct list *);
-struct list_elem *list_prev(struct list_elem *);
-struct list_elem *list_rend(struct list *);
+LIST_ACCESSOR struct list_elem *list_rbegin(struct list *);
+LIST_ACCESSOR struct list_elem *list_prev(struct list_elem *);
+LIST_ACCESSOR struct list_elem *list_rend(struct list *);
 
-struct list_elem *list_head(struct list *);
-struct list_elem *list_tail(struct list *);
+LIST_ACCESSOR struct list_elem *list_head(struct list *);
+LIST_ACCESSOR struct list_elem *list_tail(struct list *);
 
 /** List insertion. */
 void list_insert(struct list_elem *, struct list_elem *);
@@ -146,12 +158,12 @@ struct list_elem *list_pop_front(struct list *);
 struct list_elem *list_pop_back(struct list *);
 
 /** List elements. */
-struct list_elem *list_front(struct list *);
-struct list_elem *list_back(struct list *);
+LIST_ACCESSOR struct list_elem *list_front(struct list *);
+LIST_ACCESSOR struct list_elem *list_back(struct list *);
 
 /** List properties. */
 size_t list_size(struct list *);
-bool list_empty(struct list *);
+LIST_ACCESSOR bool list_empty(struct list *);
 
 /** Miscellaneous. */
 void list_reverse(struct list *);
@@ -170,4 +182,105 @@ void list_unique(struct list *, struct list *duplicates, list_less_func *, void
 struct list_elem *list_max(struct list *list, list_less_func *less, void *aux);
 struct list_elem *list_min(struct list *list, list_less_func *less, void *aux);
 
+#if defined LIST_INLINE || defined LIST_INSTANTIATE
+#include <debug.h>
+
+/** Returns the beginning of LIST.  */
+LIST_ACCESSOR struct list_elem *list_begin(struct list *list) {
+  ASSERT(list != NULL);
+  return list->head.next;
+}
+
+/** Returns the element after ELEM in its list.  If ELEM is the
+   last element in its list, returns the list tail.  Results are
+   undefined if ELEM is itself a list tail. */
+LIST_ACCESSOR struct list_elem *list_next(struct list_elem *elem) {
+  ASSERT(elem != NULL && elem->next != NULL); /* Head or interior. */
+  return elem->next;
+}
+
+/** Returns LIST's tail.
+
+   list_end() is often used in iterating through a list from
+   front to back.  See the big comment at the top of list.h for
+   an example. */
+LIST_ACCESSOR struct list_elem *list_end(struct list *list) {
+  ASSERT(list != NULL);
+  return &list->tail;
+}
+
+/** Returns the LIST's reverse beginning, for iterating through
+   LIST in reverse order, from back to front. */
+LIST_ACCESSOR struct list_elem *list_rbegin(struct list *list) {
+  ASSERT(list != NULL);
+  return list->tail.prev;
+}
+
+/** Returns the element before ELEM in its list.  If ELEM is the
+   first element in its list, returns the list head.  Results are
+   undefined if ELEM is itself a list head. */
+LIST_ACCESSOR struct list_elem *list_prev(struct list_elem *elem) {
+  ASSERT(elem != NULL && elem->prev != NULL); /* Interior or tail. */
+  return elem->prev;
+}
+
+/** Returns LIST's head.
+
+   list_rend() is often used in iterating through a list in
+   reverse order, from back to front.  Here's typical usage,
+   following the example from the top of this file:
+
+      for (e = list_rbegin (&foo_list); e != list_rend (&foo_list);
+           e = list_prev (e))
+        {
+          struct foo *f = container_of (e, struct foo, elem);
+          ...do something with f...
+        }
+*/
+LIST_ACCESSOR struct list_elem *list_rend(struct list *list) {
+  ASSERT(list != NULL);
+  return &list->head;
+}
+
+/** Return's LIST's head.
+
+   list_head() can be used for an alternate style of iterating
+   through a list, e.g.:
+
+      e = list_head (&list);
+      while ((e = list_next (e)) != list_end (&list))
+        {
+          ...
+        }
+*/
+LIST_ACCESSOR struct list_elem *list_head(struct list *list) {
+  ASSERT(list != NULL);
+  return &list->head;
+}
+
+/** Return's LIST's tail. */
+LIST_ACCESSOR struct list_elem *list_tail(struct list *list) {
+  ASSERT(list != NULL);
+  return &list->tail;
+}
+
+/** Returns the front element in LIST.
+   Undefined behavior if LIST is empty. */
+LIST_ACCESSOR struct list_elem *list_front(struct list *list) {
+  ASSERT(!list_empty(list));
+  return list->head.next;
+}
+
+/** Returns the back element in LIST.
+   Undefined behavior if LIST is empty. */
+LIST_ACCESSOR struct list_elem *list_back(struct list *list) {
+  ASSERT(!list_empty(list));
+  return list->tail.prev;
+}
+
+/** Returns true if LIST is empty, false otherwise. */
+LIST_ACCESSOR bool list_empty(struct list *list) { return list_begin(list) == list_end(list); }
+
+#endif /**< LIST_INLINE || LIST_INSTANTIATE */
+
 #endif /**< lib/kernel/list.h */
@@ -0,0 +1,360 @@
+/** Red-black tree.
+
+   The algorithms follow [CLRS] chapter 13, with null pointers
+   for the leaves instead of a sentinel node so that a struct
+   rb_tree needs no storage of its own.  See rbtree.h for basic
+   information. */
+
+#include "rbtree.h"
+
+#include "../debug.h"
+
+static void replace_child(struct rb_tree *, struct rb_node *old, struct rb_node *new);
+static void rotate_left(struct rb_tree *, struct rb_node *);
+static void rotate_right(struct rb_tree *, struct rb_node *);
+static void update_path(struct rb_tree *, struct rb_node *);
+static void insert_fixup(struct rb_tree *, struct rb_node *);
+static void remove_fixup(struct rb_tree *, struct rb_node *, struct rb_node *parent);
+
+/** Returns true if N is a red node.  Leaves are black. */
+static inline bool is_red(const struct rb_node *n) { return n != NULL && n->red; }
+
+/** Initializes TREE as an empty tree ordered by LESS, given
+   auxiliary data AUX.  If UPDATE is nonnull, it maintains
+   augmented data in the nodes, as described in rbtree.h. */
+void rb_init(struct rb_tree *tree, rb_less_func *less, rb_update_func *update, void *aux) {
+  ASSERT(tree != NULL);
+  ASSERT(less != NULL);
+
+  tree->root = NULL;
+  tree->less = less;
+  tree->update = update;
+  tree->aux = aux;
+}
+
+/** Inserts NODE into TREE, after any nodes equal to it. */
+void rb_insert(struct rb_tree *tree, struct rb_node *node) {
+  struct rb_node **link = &tree->root;
+  struct rb_node *parent = NULL;
+
+  ASSERT(node != NULL);
+
+  while (*link != NULL) {
+    parent = *link;
+    link = tree->less(node, parent, tree->aux) ? &parent->left : &parent->right;
+  }
+
+  node->parent = parent;
+  node->left = node->right = NULL;
+  node->red = true;
+  *link = node;
+
+  update_path(tree, node);
+  insert_fixup(tree, node);
+}
+
+/** Removes NODE, which must be in TREE, from TREE. */
+void rb_remove(struct rb_tree *tree, struct rb_node *node) {
+  struct rb_node *child, *parent;
+  bool removed_red;
+
+  ASSERT(node != NULL);
+
+  if (node->left == NULL || node->right == NULL) {
+    /* NODE has at most one child, which takes its place. */
+    child = node->left != NULL ? node->left : node->right;
+    parent = node->parent;
+    removed_red = node->red;
+    replace_child(tree, node, child);
+  } else {
+    /* NODE's successor, which has no left child, takes its
+       place and its color.  What is really taken out of the
+       tree is the successor's old position. */
+    struct rb_node *succ = node->right;
+
+    while (succ->left != NULL) succ = succ->left;
+    child = succ->right;
+    removed_red = succ->red;
+
+    if (succ->parent == node)
+      parent = succ;
+    else {
+      parent = succ->parent;
+      parent->left = child;
+      if (child != NULL) child->parent = parent;
+      succ->right = node->right;
+      succ->right->parent = succ;
+    }
+    succ->left = node->left;
+    succ->left->parent = succ;
+    succ->red = node->red;
+    replace_child(tree, node, succ);
+  }
+
+  update_path(tree, parent);
+  if (!removed_red) remove_fixup(tree, child, parent);
+}
+
+/** Returns a node in TREE equal to KEY, or a null pointer if
+   there is none. */
+struct rb_node *rb_find(const struct rb_tree *tree, const struct rb_node *key) {
+  struct rb_node *n = tree->root;
+
+  while (n != NULL)
+    if (tree->less(key, n, tree->aux))
+      n = n->left;
+    else if (tree->less(n, key, tree->aux))
+      n = n->right;
+    else
+      return n;
+  return NULL;
+}
+
+/** Returns the first node in TREE that is not less than KEY, or
+   a null pointer if there is none. */
+struct rb_node *rb_lower_bound(const struct rb_tree *tree, const struct rb_node *key) {
+  struct rb_node *n = tree->root;
+  struct rb_node *bound = NULL;
+
+  while (n != NULL)
+    if (!tree->less(n, key, tree->aux)) {
+      bound = n;
+      n = n->left;
+    } else
+      n = n->right;
+  return bound;
+}
+
+/** Returns the first node in TREE that is greater than KEY, or a
+   null pointer if there is none. */
+struct rb_node *rb_upper_bound(const struct rb_tree *tree, const struct rb_node *key) {
+  struct rb_node *n = tree->root;
+  struct rb_node *bound = NULL;
+
+  while (n != NULL)
+    if (tree->less(key, n, tree->aux)) {
+      bound = n;
+      n = n->left;
+    } else
+      n = n->right;
+  return bound;
+}
+
+/** Returns the smallest node in TREE, or a null pointer if TREE
+   is empty. */
+struct rb_node *rb_first(const struct rb_tree *tree) {
+  struct rb_node *n = tree->root;
+
+  if (n != NULL)
+    while (n->left != NULL) n = n->left;
+  return n;
+}
+
+/** Returns the largest node in TREE, or a null pointer if TREE
+   is empty. */
+struct rb_node *rb_last(const struct rb_tree *tree) {
+  struct rb_node *n = tree->root;
+
+  if (n != NULL)
+    while (n->right != NULL) n = n->right;
+  return n;
+}
+
+/** Returns the node after N in its tree, or a null pointer if N
+   is the last node. */
+struct rb_node *rb_next(const struct rb_node *n) {
+  ASSERT(n != NULL);
+
+  if (n->right != NULL) {
+    n = n->right;
+    while (n->left != NULL) n = n->left;
+    return (struct rb_node *)n;
+  }
+  while (n->parent != NULL && n == n->parent->right) n = n->parent;
+  return n->parent;
+}
+
+/** Returns the node before N in its tree, or a null pointer if N
+   is the first node. */
+struct rb_node *rb_prev(const struct rb_node *n) {
+  ASSERT(n != NULL);
+
+  if (n->left != NULL) {
+    n = n->left;
+    while (n->right != NULL) n = n->right;
+    return (struct rb_node *)n;
+  }
+  while (n->parent != NULL && n == n->parent->left) n = n->parent;
+  return n->parent;
+}
+
+/** Returns true if TREE is empty, false otherwise. */
+bool rb_empty(const struct rb_tree *tree) { return tree->root == NULL; }
+
+/** Puts NEW, which may be null, where OLD was in TREE's links
+   from OLD's parent. */
+static void replace_child(struct rb_tree *tree, struct rb_node *old, struct rb_node *new) {
+  struct rb_node *parent = old->parent;
+
+  if (parent == NULL)
+    tree->root = new;
+  else if (parent->left == old)
+    parent->left = new;
+  else
+    parent->right = new;
+  if (new != NULL) new->parent = parent;
+}
+
+/** Rotates N's right child into N's place, making N its left
+   child.  The subtree as a whole keeps the same nodes, so only
+   the two rotated nodes need their augmented data updated. */
+static void rotate_left(struct rb_tree *tree, struct rb_node *n) {
+  struct rb_node *r = n->right;
+
+  n->right = r->left;
+  if (r->left != NULL) r->left->parent = n;
+  replace_child(tree, n, r);
+  r->left = n;
+  n->parent = r;
+
+  if (tree->update != NULL) {
+    tree->update(n, tree->aux);
+    tree->update(r, tree->aux);
+  }
+}
+
+/** Rotates N's left child into N's place, making N its right
+   child. */
+static void rotate_right(struct rb_tree *tree, struct rb_node *n) {
+  struct rb_node *l = n->left;
+
+  n->left = l->right;
+  if (l->right != NULL) l->right->parent = n;
+  replace_child(tree, n, l);
+  l->right = n;
+  n->parent = l;
+
+  if (tree->update != NULL) {
+    tree->update(n, tree->aux);
+    tree->update(l, tree->aux);
+  }
+}
+
+/** Updates the augmented data of N and each of its ancestors, if
+   TREE has an update function. */
+static void update_path(struct rb_tree *tree, struct rb_node *n) {
+  if (tree->update != NULL)
+    for (; n != NULL; n = n->parent) tree->update(n, tree->aux);
+}
+
+/** Restores the red-black properties after red node N has been
+   inserted into TREE. */
+static void insert_fixup(struct rb_tree *tree, struct rb_node *n) {
+  struct rb_node *parent;
+
+  while ((parent = n->parent) != NULL && parent->red) {
+    /* A red node is never the root, so PARENT has a parent. */
+    struct rb_node *grandparent = parent->parent;
+
+    if (parent == grandparent->left) {
+      struct rb_node *uncle = grandparent->right;
+
+      if (is_red(uncle)) {
+        parent->red = uncle->red = false;
+        grandparent->red = true;
+        n = grandparent;
+      } else {
+        if (n == parent->right) {
+          rotate_left(tree, parent);
+          n = parent;
+          parent = n->parent;
+        }
+        parent->red = false;
+        grandparent->red = true;
+        rotate_right(tree, grandparent);
+      }
+    } else {
+      struct rb_node *uncle = grandparent->left;
+
+      if (is_red(uncle)) {
+        parent->red = uncle->red = false;
+        grandparent->red = true;
+        n = grandparent;
+      } else {
+        if (n == parent->left) {
+          rotate_right(tree, parent);
+          n = parent;
+          parent = n->parent;
+        }
+        parent->red = false;
+        grandparent->red = true;
+        rotate_left(tree, grandparent);
+      }
+    }
+  }
+  tree->root->red = false;
+}
+
+/** Restores the red-black properties after a black node has been
+   removed from TREE.  N, which may be null, is the node that took
+   its place, and PARENT is N's parent. */
+static void remove_fixup(struct rb_tree *tree, struct rb_node *n, struct rb_node *parent) {
+  while (n != tree->root && !is_red(n)) {
+    /* The removed node was black, so N's sibling subtree has at
+       least one black node and the sibling is not null. */
+    if (n == parent->left) {
+      struct rb_node *sibling = parent->right;
+
+      if (sibling->red) {
+        sibling->red = false;
+        parent->red = true;
+        rotate_left(tree, parent);
+        sibling = parent->right;
+      }
+      if (!is_red(sibling->left) && !is_red(sibling->right)) {
+        sibling->red = true;
+        n = parent;
+        parent = n->parent;
+      } else {
+        if (!is_red(sibling->right)) {
+          sibling->left->red = false;
+          sibling->red = true;
+          rotate_right(tree, sibling);
+          sibling = parent->right;
+        }
+        sibling->red = parent->red;
+        parent->red = false;
+        sibling->right->red = false;
+        rotate_left(tree, parent);
+        n = tree->root;
+      }
+    } else {
+      struct rb_node *sibling = parent->left;
+
+      if (sibling->red) {
+        sibling->red = false;
+        parent->red = true;
+        rotate_right(tree, parent);
+        sibling = parent->left;
+      }
+      if (!is_red(sibling->left) && !is_red(sibling->right)) {
+        sibling->red = true;
+        n = parent;
+        parent = n->parent;
+      } else {
+        if (!is_red(sibling->left)) {
+          sibling->right->red = false;
+          sibling->red = true;
+          rotate_left(tree, sibling);
+          sibling = parent->left;
+        }
+        sibling->red = parent->red;
+        parent->red = false;
+        sibling->left->red = false;
+        rotate_right(tree, parent);
+        n = tree->root;
+      }
+    }
+  }
+  if (n != NULL) n->red = false;
+}
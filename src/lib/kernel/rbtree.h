@@ -0,0 +1,111 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/** Red-black tree.
+
+   A balanced binary search tree: insertion, removal, search, and
+   finding the first element are all O(lg n), where a sorted list
+   built with list_insert_ordered() takes O(n) to insert.
+
+   Like the list and hash table, the tree does not allocate.
+   Each structure that can be in a tree embeds a struct rb_node
+   member, and the rb_entry macro converts a struct rb_node back
+   to the structure that contains it:
+
+      struct foo
+        {
+          struct rb_node node;
+          int key;
+          ...other members...
+        };
+
+      static bool
+      foo_less (const struct rb_node *a, const struct rb_node *b,
+                void *aux UNUSED)
+      {
+        return (rb_entry (a, struct foo, node)->key
+                < rb_entry (b, struct foo, node)->key);
+      }
+
+   The tree is ordered by a comparison function given to
+   rb_init().  Searches take a "key" node, usually embedded in a
+   struct on the caller's stack with only the compared members
+   set.  Elements that compare equal may be inserted more than
+   once; each is placed after those already in the tree.
+
+   Iteration goes from rb_first() or a bound towards rb_next(),
+   and ends at a null pointer.  To visit every element whose key
+   lies in [LO, HI):
+
+      struct rb_node *n;
+
+      for (n = rb_lower_bound (&tree, &lo.node);
+           n != NULL && foo_less (n, &hi.node, NULL);
+           n = rb_next (n))
+        ...
+
+   Augmented trees.  If an update function is given to rb_init(),
+   the tree calls it on a node whenever that node's subtree has
+   changed, after the update of its children.  The function can
+   then recompute data summarizing the subtree from the node
+   itself and its children, such as the largest end of any
+   interval in the subtree, which allows searching for
+   overlapping intervals in O(lg n). */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Tree node. */
+struct rb_node {
+  struct rb_node *parent; /**< Parent, or NULL for the root. */
+  struct rb_node *left;   /**< Left child, or NULL. */
+  struct rb_node *right;  /**< Right child, or NULL. */
+  bool red;               /**< Red or black? */
+};
+
+/** Converts pointer to tree node RB_NODE into a pointer to the
+   structure that RB_NODE is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree node.  See the big comment at the top of the file for an
+   example. */
+#define rb_entry(RB_NODE, STRUCT, MEMBER) ((STRUCT *)((uint8_t *)&(RB_NODE)->parent - offsetof(STRUCT, MEMBER.parent)))
+
+/** Compares the value of two tree nodes A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rb_less_func(const struct rb_node *a, const struct rb_node *b, void *aux);
+
+/** Recomputes the augmented data of node N from N and its
+   children, given auxiliary data AUX. */
+typedef void rb_update_func(struct rb_node *n, void *aux);
+
+/** Red-black tree. */
+struct rb_tree {
+  struct rb_node *root;   /**< Root node, or NULL if empty. */
+  rb_less_func *less;     /**< Comparison function. */
+  rb_update_func *update; /**< Augmentation function, or NULL. */
+  void *aux;              /**< Auxiliary data for `less' and `update'. */
+};
+
+void rb_init(struct rb_tree *, rb_less_func *, rb_update_func *, void *aux);
+
+/** Insertion and removal. */
+void rb_insert(struct rb_tree *, struct rb_node *);
+void rb_remove(struct rb_tree *, struct rb_node *);
+
+/** Search. */
+struct rb_node *rb_find(const struct rb_tree *, const struct rb_node *key);
+struct rb_node *rb_lower_bound(const struct rb_tree *, const struct rb_node *key);
+struct rb_node *rb_upper_bound(const struct rb_tree *, const struct rb_node *key);
+
+/** Traversal. */
+struct rb_node *rb_first(const struct rb_tree *);
+struct rb_node *rb_last(const struct rb_tree *);
+struct rb_node *rb_next(const struct rb_node *);
+struct rb_node *rb_prev(const struct rb_node *);
+
+/** Properties. */
+bool rb_empty(const struct rb_tree *);
+
+#endif /**< lib/kernel/rbtree.h */
@@ -0,0 +1,384 @@
+/** Open-addressing hash table.
+
+   See rhash.h for basic information. */
+
+#include "rhash.h"
+
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/** Smallest number of slots in a table. */
+#define MIN_SLOTS 8
+
+/** Slots of the old table moved by each insertion or deletion.
+   Growing doubles the table when it is 7/8 full, so the old
+   table is empty long before the new one fills up. */
+#define MOVE_STEP 4
+
+static bool table_init(struct rhash_table *, size_t slot_cnt);
+static struct rhash_elem *table_find(struct rhash *, struct rhash_table *, struct rhash_elem *, size_t *idx);
+static void table_insert(struct rhash_table *, struct rhash_elem *);
+static void table_remove(struct rhash_table *, size_t idx);
+static struct rhash_elem *find_elem(struct rhash *, struct rhash_elem *, struct rhash_table **, size_t *idx);
+static bool make_room(struct rhash *);
+static void resize(struct rhash *, size_t slot_cnt);
+static void move_slots(struct rhash *, size_t cnt);
+
+/** Initializes hash table H to compute hash values using HASH and
+   compare hash elements using LESS, given auxiliary data AUX. */
+bool rhash_init(struct rhash *h, rhash_hash_func *hash, rhash_less_func *less, void *aux) {
+  h->old.slots = NULL;
+  h->old.mask = 0;
+  h->old.elem_cnt = 0;
+  h->move_idx = 0;
+  h->hash = hash;
+  h->less = less;
+  h->aux = aux;
+
+  return table_init(&h->cur, MIN_SLOTS);
+}
+
+/** Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while rhash_clear() is running, using any of the
+   functions rhash_clear(), rhash_destroy(), rhash_insert(),
+   rhash_replace(), or rhash_delete(), yields undefined behavior,
+   whether done in DESTRUCTOR or elsewhere. */
+void rhash_clear(struct rhash *h, rhash_action_func *destructor) {
+  size_t i;
+
+  if (destructor != NULL) rhash_apply(h, destructor);
+
+  for (i = 0; i <= h->cur.mask; i++) h->cur.slots[i].elem = NULL;
+  h->cur.elem_cnt = 0;
+
+  free(h->old.slots);
+  h->old.slots = NULL;
+  h->old.elem_cnt = 0;
+}
+
+/** Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash, as in rhash_clear(). */
+void rhash_destroy(struct rhash *h, rhash_action_func *destructor) {
+  if (destructor != NULL) rhash_apply(h, destructor);
+  free(h->cur.slots);
+  free(h->old.slots);
+  h->cur.slots = h->old.slots = NULL;
+}
+
+/** Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW.
+   If the table is full and cannot grow, returns NEW without
+   inserting it. */
+struct rhash_elem *rhash_insert(struct rhash *h, struct rhash_elem *new) {
+  struct rhash_table *t;
+  size_t idx;
+  struct rhash_elem *old = find_elem(h, new, &t, &idx);
+
+  if (old == NULL) {
+    if (!make_room(h)) return new;
+    table_insert(&h->cur, new);
+  }
+
+  move_slots(h, MOVE_STEP);
+
+  return old;
+}
+
+/** Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned.
+   If the table is full and cannot grow, returns NEW without
+   inserting it. */
+struct rhash_elem *rhash_replace(struct rhash *h, struct rhash_elem *new) {
+  struct rhash_table *t;
+  size_t idx;
+  struct rhash_elem *old = find_elem(h, new, &t, &idx);
+
+  /* Equal elements have equal hashes, so NEW can simply take
+     the old element's slot. */
+  if (old != NULL)
+    t->slots[idx].elem = new;
+  else {
+    if (!make_room(h)) return new;
+    table_insert(&h->cur, new);
+  }
+
+  move_slots(h, MOVE_STEP);
+
+  return old;
+}
+
+/** Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table. */
+struct rhash_elem *rhash_find(struct rhash *h, struct rhash_elem *e) {
+  struct rhash_table *t;
+  size_t idx;
+
+  return find_elem(h, e, &t, &idx);
+}
+
+/** Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct rhash_elem *rhash_delete(struct rhash *h, struct rhash_elem *e) {
+  struct rhash_table *t;
+  size_t idx;
+  struct rhash_elem *found = find_elem(h, e, &t, &idx);
+
+  if (found != NULL) {
+    size_t slot_cnt = h->cur.mask + 1;
+
+    table_remove(t, idx);
+    move_slots(h, MOVE_STEP);
+
+    /* Shrink once the table is less than 1/8 full. */
+    if (h->old.slots == NULL && slot_cnt > MIN_SLOTS && h->cur.elem_cnt < slot_cnt / 8) resize(h, slot_cnt / 2);
+  }
+  return found;
+}
+
+/** Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while rhash_apply() is running, using
+   any of the functions rhash_clear(), rhash_destroy(),
+   rhash_insert(), rhash_replace(), or rhash_delete(), yields
+   undefined behavior, whether done from ACTION or elsewhere. */
+void rhash_apply(struct rhash *h, rhash_action_func *action) {
+  struct rhash_iterator i;
+
+  ASSERT(action != NULL);
+
+  rhash_first(&i, h);
+  while (rhash_next(&i)) action(rhash_cur(&i), h->aux);
+}
+
+/** Initializes I for iterating hash table H.
+
+   Iteration idiom:
+
+      struct rhash_iterator i;
+
+      rhash_first (&i, h);
+      while (rhash_next (&i))
+        {
+          struct foo *f = rhash_entry (rhash_cur (&i), struct foo, elem);
+          ...do something with f...
+        }
+
+   Modifying hash table H during iteration, using any of the
+   functions rhash_clear(), rhash_destroy(), rhash_insert(),
+   rhash_replace(), or rhash_delete(), invalidates all
+   iterators. */
+void rhash_first(struct rhash_iterator *i, struct rhash *h) {
+  ASSERT(i != NULL);
+  ASSERT(h != NULL);
+
+  i->hash = h;
+  i->table = h->old.slots != NULL ? &h->old : &h->cur;
+  i->idx = 0;
+  i->elem = NULL;
+}
+
+/** Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order.
+
+   Modifying a hash table H during iteration, using any of the
+   functions rhash_clear(), rhash_destroy(), rhash_insert(),
+   rhash_replace(), or rhash_delete(), invalidates all
+   iterators. */
+struct rhash_elem *rhash_next(struct rhash_iterator *i) {
+  ASSERT(i != NULL);
+
+  for (;;) {
+    struct rhash_table *t = i->table;
+
+    while (i->idx <= t->mask) {
+      struct rhash_slot *s = &t->slots[i->idx++];
+      if (s->elem != NULL) return i->elem = s->elem;
+    }
+    if (t == &i->hash->cur) break;
+
+    i->table = &i->hash->cur;
+    i->idx = 0;
+  }
+
+  return i->elem = NULL;
+}
+
+/** Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling rhash_first() but before rhash_next(). */
+struct rhash_elem *rhash_cur(struct rhash_iterator *i) { return i->elem; }
+
+/** Returns the number of elements in H. */
+size_t rhash_size(struct rhash *h) { return h->cur.elem_cnt + h->old.elem_cnt; }
+
+/** Returns true if H contains no elements, false otherwise. */
+bool rhash_empty(struct rhash *h) { return rhash_size(h) == 0; }
+
+/** Returns true if H has been initialized with rhash_init() and
+   not since destroyed, false if it has been destroyed or is all
+   zeros, as in a struct that was zeroed and never initialized.
+   Only such a table may be passed to the other functions. */
+bool rhash_initialized(const struct rhash *h) { return h->cur.slots != NULL; }
+
+/** Initializes T as an empty table of SLOT_CNT slots, which must
+   be a power of 2.  Returns false if memory allocation fails. */
+static bool table_init(struct rhash_table *t, size_t slot_cnt) {
+  t->slots = calloc(slot_cnt, sizeof *t->slots);
+  t->mask = slot_cnt - 1;
+  t->elem_cnt = 0;
+  return t->slots != NULL;
+}
+
+/** Returns how far the element in slot IDX of T is from the slot
+   its hash value points to. */
+static inline size_t probe_distance(const struct rhash_table *t, size_t idx) { return (idx - t->slots[idx].hash) & t->mask; }
+
+/** Searches T, part of H, for an element equal to E, whose hash
+   value must already be in E->hash.  Returns it and stores its
+   slot index in *IDX if found, or returns a null pointer
+   otherwise. */
+static struct rhash_elem *table_find(struct rhash *h, struct rhash_table *t, struct rhash_elem *e, size_t *idx) {
+  size_t i, dist;
+
+  /* Elements are never further from home than the ones before
+     them in the probe sequence were from theirs, so the search
+     stops at the first slot that is closer to its own home than
+     E would be.  That always comes before wrapping around. */
+  for (i = e->hash & t->mask, dist = 0;; i = (i + 1) & t->mask, dist++) {
+    struct rhash_slot *s = &t->slots[i];
+
+    if (s->elem == NULL || probe_distance(t, i) < dist) return NULL;
+    if (s->hash == e->hash && !h->less(s->elem, e, h->aux) && !h->less(e, s->elem, h->aux)) {
+      *idx = i;
+      return s->elem;
+    }
+  }
+}
+
+/** Inserts E, whose hash value must already be in E->hash, into
+   T, which must have at least one empty slot. */
+static void table_insert(struct rhash_table *t, struct rhash_elem *e) {
+  struct rhash_slot carry = {e->hash, e};
+  size_t i, dist;
+
+  ASSERT(t->elem_cnt <= t->mask);
+
+  for (i = carry.hash & t->mask, dist = 0;; i = (i + 1) & t->mask, dist++) {
+    struct rhash_slot *s = &t->slots[i];
+    size_t s_dist;
+
+    if (s->elem == NULL) {
+      *s = carry;
+      t->elem_cnt++;
+      return;
+    }
+
+    /* Take the slot from an element closer to its home, and go
+       on to find a place for that one instead. */
+    s_dist = probe_distance(t, i);
+    if (s_dist < dist) {
+      struct rhash_slot tmp = *s;
+      *s = carry;
+      carry = tmp;
+      dist = s_dist;
+    }
+  }
+}
+
+/** Removes the element in slot IDX of T, shifting the elements
+   after it that are not in their home slots back by one. */
+static void table_remove(struct rhash_table *t, size_t idx) {
+  for (;;) {
+    size_t next = (idx + 1) & t->mask;
+
+    if (t->slots[next].elem == NULL || probe_distance(t, next) == 0) break;
+    t->slots[idx] = t->slots[next];
+    idx = next;
+  }
+  t->slots[idx].elem = NULL;
+  t->elem_cnt--;
+}
+
+/** Computes E's hash value and searches both tables of H for an
+   element equal to E.  If one is found, returns it and stores
+   its table and slot index in *T and *IDX.  Otherwise, returns a
+   null pointer. */
+static struct rhash_elem *find_elem(struct rhash *h, struct rhash_elem *e, struct rhash_table **t, size_t *idx) {
+  struct rhash_elem *found;
+
+  e->hash = h->hash(e, h->aux);
+
+  *t = &h->cur;
+  found = table_find(h, *t, e, idx);
+  if (found == NULL && h->old.slots != NULL) {
+    *t = &h->old;
+    found = table_find(h, *t, e, idx);
+  }
+  return found;
+}
+
+/** Makes sure that the current table of H has room for another
+   element, growing it if it is 7/8 full.  Growing can fail
+   because of an out-of-memory condition, but the table is still
+   usable until it is completely full; returns false only then. */
+static bool make_room(struct rhash *h) {
+  size_t slot_cnt = h->cur.mask + 1;
+
+  if (h->cur.elem_cnt + 1 > slot_cnt - slot_cnt / 8) resize(h, slot_cnt * 2);
+  return h->cur.elem_cnt <= h->cur.mask;
+}
+
+/** Replaces the current table of H by an empty one of SLOT_CNT
+   slots, leaving its elements to be moved over a few at a time
+   by move_slots().  Does nothing if memory allocation fails. */
+static void resize(struct rhash *h, size_t slot_cnt) {
+  struct rhash_table new;
+
+  if (!table_init(&new, slot_cnt)) return;
+
+  /* Only one table can be draining at a time. */
+  move_slots(h, SIZE_MAX);
+
+  h->old = h->cur;
+  h->cur = new;
+  h->move_idx = 0;
+  move_slots(h, 0);
+}
+
+/** Moves the elements in up to CNT slots of H's old table into
+   its current table, and frees the old table once it is empty. */
+static void move_slots(struct rhash *h, size_t cnt) {
+  struct rhash_table *old = &h->old;
+
+  if (old->slots == NULL) return;
+
+  /* Removing an element may shift the next one back into the
+     same slot, so empty each slot completely before going on.
+     Slots already passed stay empty. */
+  for (; cnt > 0 && old->elem_cnt > 0; cnt--, h->move_idx++)
+    while (old->slots[h->move_idx].elem != NULL) {
+      struct rhash_elem *e = old->slots[h->move_idx].elem;
+
+      table_remove(old, h->move_idx);
+      table_insert(&h->cur, e);
+    }
+
+  if (old->elem_cnt == 0) {
+    free(old->slots);
+    old->slots = NULL;
+  }
+}
@@ -0,0 +1,115 @@
+#ifndef __LIB_KERNEL_RHASH_H
+#define __LIB_KERNEL_RHASH_H
+
+/** Open-addressing hash table.
+
+   This is an alternative to the chained hash table in hash.h for
+   tables that are searched much more often than they change.
+   Instead of a linked list per bucket, the table is a single
+   array of slots, each holding a pointer to an element and that
+   element's full hash value.  A search walks consecutive slots,
+   so it touches one or two cache lines and calls the comparison
+   function only for slots whose stored hash matches.
+
+   Collisions are resolved by Robin Hood linear probing: an
+   element being inserted takes the slot of any element that is
+   closer to its own home slot, so probe sequences stay short and
+   a search can stop as soon as it passes the point where the
+   element would have been.  Deletion shifts the following
+   elements back instead of leaving tombstones.
+
+   Growing or shrinking the table does not move every element at
+   once.  The old array is kept alongside the new one and a few
+   of its slots are moved by each later insertion or deletion, so
+   no single operation pays for the whole rehash.
+
+   Like hash.h, the table does not allocate per element: each
+   structure that can be in a table embeds a struct rhash_elem,
+   and the rhash_entry macro converts back to the structure.
+
+   Unlike hash.h, insertion can fail when the table is full and
+   cannot grow, in which case rhash_insert() and rhash_replace()
+   return the new element itself. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Hash element. */
+struct rhash_elem {
+  unsigned hash; /**< Hash value, set on insertion. */
+};
+
+/** Converts pointer to hash element RHASH_ELEM into a pointer to
+   the structure that RHASH_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the hash element. */
+#define rhash_entry(RHASH_ELEM, STRUCT, MEMBER) ((STRUCT *)((uint8_t *)&(RHASH_ELEM)->hash - offsetof(STRUCT, MEMBER.hash)))
+
+/** Computes and returns the hash value for hash element E, given
+   auxiliary data AUX. */
+typedef unsigned rhash_hash_func(const struct rhash_elem *e, void *aux);
+
+/** Compares the value of two hash elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rhash_less_func(const struct rhash_elem *a, const struct rhash_elem *b, void *aux);
+
+/** Performs some operation on hash element E, given auxiliary
+   data AUX. */
+typedef void rhash_action_func(struct rhash_elem *e, void *aux);
+
+/** A slot in a table array. */
+struct rhash_slot {
+  unsigned hash;           /**< Hash value of ELEM. */
+  struct rhash_elem *elem; /**< Element, or NULL if the slot is empty. */
+};
+
+/** One array of slots. */
+struct rhash_table {
+  struct rhash_slot *slots; /**< Array of `mask + 1' slots. */
+  size_t mask;              /**< Number of slots minus 1; slot count is a power of 2. */
+  size_t elem_cnt;          /**< Number of elements in `slots'. */
+};
+
+/** Hash table. */
+struct rhash {
+  struct rhash_table cur; /**< Table that receives insertions. */
+  struct rhash_table old; /**< Table being moved into `cur', if `old.slots' is nonnull. */
+  size_t move_idx;        /**< Next slot of `old' to move. */
+  rhash_hash_func *hash;  /**< Hash function. */
+  rhash_less_func *less;  /**< Comparison function. */
+  void *aux;              /**< Auxiliary data for `hash' and `less'. */
+};
+
+/** A hash table iterator. */
+struct rhash_iterator {
+  struct rhash *hash;        /**< The hash table. */
+  struct rhash_table *table; /**< Table being iterated. */
+  size_t idx;                /**< Index of the next slot to examine. */
+  struct rhash_elem *elem;   /**< Current hash element. */
+};
+
+/** Basic life cycle. */
+bool rhash_init(struct rhash *, rhash_hash_func *, rhash_less_func *, void *aux);
+void rhash_clear(struct rhash *, rhash_action_func *);
+void rhash_destroy(struct rhash *, rhash_action_func *);
+
+/** Search, insertion, deletion. */
+struct rhash_elem *rhash_insert(struct rhash *, struct rhash_elem *);
+struct rhash_elem *rhash_replace(struct rhash *, struct rhash_elem *);
+struct rhash_elem *rhash_find(struct rhash *, struct rhash_elem *);
+struct rhash_elem *rhash_delete(struct rhash *, struct rhash_elem *);
+
+/** Iteration. */
+void rhash_apply(struct rhash *, rhash_action_func *);
+void rhash_first(struct rhash_iterator *, struct rhash *);
+struct rhash_elem *rhash_next(struct rhash_iterator *);
+struct rhash_elem *rhash_cur(struct rhash_iterator *);
+
+/** Information. */
+size_t rhash_size(struct rhash *);
+bool rhash_empty(struct rhash *);
+bool rhash_initialized(const struct rhash *);
+
+#endif /**< lib/kernel/rhash.h */
@@ -0,0 +1,124 @@
+#ifndef __LIB_SORT_H
+#define __LIB_SORT_H
+
+/** Sorting with a fixed element type.
+
+   sort() and qsort() in <stdlib.h> handle any element size and
+   call the comparison function through a pointer for every
+   comparison.  When the element type is known at compile time,
+
+      SORT_DEFINE (NAME, TYPE, LESS)
+
+   instead defines a function
+
+      static void NAME (TYPE *array, size_t cnt);
+
+   that sorts the CNT elements of ARRAY into ascending order.
+   LESS is a function or function-like macro that is passed two
+   pointers to const TYPE, A and B, and returns true if A is less
+   than B.  Since LESS is expanded in place, the compiler can
+   inline it, and elements are moved by assignment rather than
+   byte by byte.  For example:
+
+      #define INT_LESS(A, B) (*(A) < *(B))
+      SORT_DEFINE (sort_ints, int, INT_LESS)
+
+   The algorithm is introsort: quicksort with a median-of-three
+   pivot, insertion sort for small partitions, and heapsort once
+   the recursion gets too deep.  It runs in O(n lg n) time and
+   O(lg n) space and is not stable. */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Partitions of at most this many elements are finished by
+   insertion sort. */
+#define SORT_INSERTION_MAX 16
+
+/** Swaps A and B, both lvalues of type TYPE. */
+#define SORT_SWAP(TYPE, A, B) \
+  do {                        \
+    TYPE sort_tmp_ = (A);     \
+    (A) = (B);                \
+    (B) = sort_tmp_;          \
+  } while (0)
+
+#define SORT_DEFINE(NAME, TYPE, LESS)                                            \
+  /* Floats element I down the heap of the first CNT elements. */                \
+  static inline void NAME##_heapify(TYPE *array, size_t i, size_t cnt) {         \
+    for (;;) {                                                                   \
+      size_t left = 2 * i + 1;                                                   \
+      size_t max = i;                                                            \
+      if (left < cnt && LESS(&array[max], &array[left])) max = left;             \
+      if (left + 1 < cnt && LESS(&array[max], &array[left + 1])) max = left + 1; \
+      if (max == i) break;                                                       \
+      SORT_SWAP(TYPE, array[i], array[max]);                                     \
+      i = max;                                                                   \
+    }                                                                            \
+  }                                                                              \
+                                                                                 \
+  /* Sorts CNT elements, switching to heapsort after DEPTH more                  \
+     partitioning steps. */                                                      \
+  static inline void NAME##_loop(TYPE *array, size_t cnt, int depth) {           \
+    size_t i, j;                                                                 \
+                                                                                 \
+    while (cnt > SORT_INSERTION_MAX) {                                           \
+      size_t last = cnt - 1, mid = cnt / 2;                                      \
+                                                                                 \
+      if (depth-- == 0) {                                                        \
+        for (i = cnt / 2; i-- > 0;) NAME##_heapify(array, i, cnt);               \
+        for (i = cnt; i-- > 1;) {                                                \
+          SORT_SWAP(TYPE, array[0], array[i]);                                   \
+          NAME##_heapify(array, 0, i);                                           \
+        }                                                                        \
+        return;                                                                  \
+      }                                                                          \
+                                                                                 \
+      /* Put the median of three in element 0 and a larger element               \
+         at the end, which stops the left-to-right scan. */                      \
+      if (LESS(&array[0], &array[mid])) SORT_SWAP(TYPE, array[0], array[mid]);   \
+      if (LESS(&array[last], &array[0])) {                                       \
+        SORT_SWAP(TYPE, array[0], array[last]);                                  \
+        if (LESS(&array[0], &array[mid])) SORT_SWAP(TYPE, array[0], array[mid]); \
+      }                                                                          \
+                                                                                 \
+      /* Hoare partition.  Both scans stop at elements equal to the              \
+         pivot, which splits runs of equal elements evenly. */                   \
+      i = 0;                                                                     \
+      j = cnt;                                                                   \
+      for (;;) {                                                                 \
+        while (LESS(&array[++i], &array[0])) continue;                           \
+        while (LESS(&array[0], &array[--j])) continue;                           \
+        if (i >= j) break;                                                       \
+        SORT_SWAP(TYPE, array[i], array[j]);                                     \
+      }                                                                          \
+      SORT_SWAP(TYPE, array[0], array[j]);                                       \
+                                                                                 \
+      /* Recurse into the smaller side, loop on the larger. */                   \
+      if (j < cnt - j - 1) {                                                     \
+        NAME##_loop(array, j, depth);                                            \
+        array += j + 1;                                                          \
+        cnt -= j + 1;                                                            \
+      } else {                                                                   \
+        NAME##_loop(array + j + 1, cnt - j - 1, depth);                          \
+        cnt = j;                                                                 \
+      }                                                                          \
+    }                                                                            \
+                                                                                 \
+    for (i = 1; i < cnt; i++) {                                                  \
+      TYPE elem_ = array[i];                                                     \
+      for (j = i; j > 0 && LESS(&elem_, &array[j - 1]); j--)                     \
+        array[j] = array[j - 1];                                                 \
+      array[j] = elem_;                                                          \
+    }                                                                            \
+  }                                                                              \
+                                                                                 \
+  static inline void NAME(TYPE *array, size_t cnt) {                             \
+    int depth = 0;                                                               \
+    size_t n;                                                                    \
+                                                                                 \
+    for (n = cnt; n > 1; n /= 2) depth += 2;                                     \
+    NAME##_loop(array, cnt, depth);                                              \
+  }
+
+#endif /**< lib/sort.h */
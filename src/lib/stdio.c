@@ -1,5 +1,6 @@
 #include <ctype.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <round.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -12,7 +13,7 @@ struct vsnprintf_aux {
   int max_length; /**< Max length of output string. */
 };
 
-static void vsnprintf_helper(char, void *);
+static void vsnprintf_helper(const char *, size_t, void *);
 
 /** Like vprintf(), except that output is stored into BUFFER,
    which must have space for BUF_SIZE characters.  Writes at most
@@ -38,10 +39,17 @@ int vsnprintf(char *buffer, size_t buf_size, const char *format, va_list args) {
 }
 
 /** Helper function for vsnprintf(). */
-static void vsnprintf_helper(char ch, void *aux_) {
+static void vsnprintf_helper(const char *s, size_t n, void *aux_) {
   struct vsnprintf_aux *aux = aux_;
 
-  if (aux->length++ < aux->max_length) *aux->p++ = ch;
+  if (aux->length < aux->max_length) {
+    size_t room = aux->max_length - aux->length;
+    size_t copy = n < room ? n : room;
+
+    memcpy(aux->p, s, copy);
+    aux->p += copy;
+  }
+  aux->length += n;
 }
 
 /** Like printf(), except that output is stored into BUFFER,
@@ -121,26 +129,44 @@ static const struct integer_base base_o = {8, "01234567", 0, 3};
 static const struct integer_base base_x = {16, "0123456789abcdef", 'x', 4};
 static const struct integer_base base_X = {16, "0123456789ABCDEF", 'X', 4};
 
+/** The decimal digits of 00...99, two characters each, so that
+   decimal conversions can divide by 100 rather than by 10. */
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
 static const char *parse_conversion(const char *format, struct printf_conversion *, va_list *);
 static void format_integer(uintmax_t value, bool is_signed, bool negative, const struct integer_base *, const struct printf_conversion *,
-                           void (*output)(char, void *), void *aux);
-static void output_dup(char ch, size_t cnt, void (*output)(char, void *), void *aux);
-static void format_string(const char *string, int length, struct printf_conversion *, void (*output)(char, void *), void *aux);
-
-void __vprintf(const char *format, va_list args, void (*output)(char, void *), void *aux) {
+                           void (*output)(const char *, size_t, void *), void *aux);
+static char *format_digits(uintmax_t value, const struct integer_base *, bool group, char *end);
+static void output_dup(char ch, size_t cnt, void (*output)(const char *, size_t, void *), void *aux);
+static void format_string(const char *string, int length, struct printf_conversion *, void (*output)(const char *, size_t, void *), void *aux);
+
+/** Formats FORMAT with ARGS, passing the output to OUTPUT along
+   with auxiliary data AUX.  OUTPUT receives the text in spans of
+   any length, not necessarily split at line or conversion
+   boundaries. */
+void __vprintf(const char *format, va_list args, void (*output)(const char *, size_t, void *), void *aux) {
   for (; *format != '\0'; format++) {
     struct printf_conversion c;
 
-    /* Literally copy non-conversions to output. */
+    /* Literally copy non-conversions to output, as one span up
+       to the next conversion. */
     if (*format != '%') {
-      output(*format, aux);
+      const char *start = format;
+
+      while (format[1] != '\0' && format[1] != '%') format++;
+      output(start, format - start + 1, aux);
       continue;
     }
     format++;
 
     /* %% => %. */
     if (*format == '%') {
-      output('%', aux);
+      output("%", 1, aux);
       continue;
     }
 
@@ -402,13 +428,16 @@ not_a_flag:
    according to the provided base B.  Details of the conversion
    are in C. */
 static void format_integer(uintmax_t value, bool is_signed, bool negative, const struct integer_base *b, const struct printf_conversion *c,
-                           void (*output)(char, void *), void *aux) {
-  char buf[64], *cp; /**< Buffer and current position. */
-  int x;             /**< `x' character to use or 0 if none. */
-  int sign;          /**< Sign character or 0 if none. */
-  int precision;     /**< Rendered precision. */
-  int pad_cnt;       /**< # of pad characters to fill field width. */
-  int digit_cnt;     /**< # of digits output so far. */
+                           void (*output)(const char *, size_t, void *), void *aux) {
+  char buf[80];                 /**< Buffer, filled from the end. */
+  char *end = buf + sizeof buf; /**< End of the number. */
+  char *cp;                     /**< Start of the number. */
+  int x;                        /**< `x' character to use or 0 if none. */
+  int sign;                     /**< Sign character or 0 if none. */
+  int precision;                /**< Rendered precision. */
+  int pad_cnt;                  /**< # of pad characters to fill field width. */
+  char prefix[3];               /**< Sign and `0x', if any. */
+  int prefix_len;               /**< # of characters in PREFIX. */
 
   /* Determine sign character, if any.
      An unsigned conversion will never have a sign character,
@@ -428,61 +457,112 @@ static void format_integer(uintmax_t value, bool is_signed, bool negative, const
      nonzero value with the # flag. */
   x = (c->flags & POUND) && value ? b->x : 0;
 
-  /* Accumulate digits into buffer.
-     This algorithm produces digits in reverse order, so later we
-     will output the buffer's content in reverse. */
-  cp = buf;
-  digit_cnt = 0;
-  while (value > 0) {
-    if ((c->flags & GROUP) && digit_cnt > 0 && digit_cnt % b->group == 0) *cp++ = ',';
-    *cp++ = b->digits[value % b->base];
-    value /= b->base;
-    digit_cnt++;
-  }
+  /* Convert the digits, which end at END. */
+  cp = format_digits(value, b, (c->flags & GROUP) != 0, end);
 
-  /* Append enough zeros to match precision.
+  /* Prepend enough zeros to match precision, leaving room in
+     BUF for the prefix.
      If requested precision is 0, then a value of zero is
      rendered as a null string, otherwise as "0".
      If the # flag is used with base 8, the result must always
      begin with a zero. */
   precision = c->precision < 0 ? 1 : c->precision;
-  while (cp - buf < precision && cp < buf + sizeof buf - 1) *cp++ = '0';
-  if ((c->flags & POUND) && b->base == 8 && (cp == buf || cp[-1] != '0')) *cp++ = '0';
+  while (end - cp < precision && cp > buf + sizeof prefix + 1) *--cp = '0';
+  if ((c->flags & POUND) && b->base == 8 && (cp == end || *cp != '0')) *--cp = '0';
+
+  prefix_len = 0;
+  if (sign) prefix[prefix_len++] = sign;
+  if (x) {
+    prefix[prefix_len++] = '0';
+    prefix[prefix_len++] = x;
+  }
 
   /* Calculate number of pad characters to fill field width. */
-  pad_cnt = c->width - (cp - buf) - (x ? 2 : 0) - (sign != 0);
+  pad_cnt = c->width - (end - cp) - prefix_len;
   if (pad_cnt < 0) pad_cnt = 0;
 
-  /* Do output. */
+  /* Do output.  Unless zeros separate them, the prefix goes into
+     BUF in front of the digits so that both are one span. */
   if ((c->flags & (MINUS | ZERO)) == 0) output_dup(' ', pad_cnt, output, aux);
-  if (sign) output(sign, aux);
-  if (x) {
-    output('0', aux);
-    output(x, aux);
+  if (c->flags & ZERO) {
+    if (prefix_len > 0) output(prefix, prefix_len, aux);
+    output_dup('0', pad_cnt, output, aux);
+  } else {
+    cp -= prefix_len;
+    memcpy(cp, prefix, prefix_len);
   }
-  if (c->flags & ZERO) output_dup('0', pad_cnt, output, aux);
-  while (cp > buf) output(*--cp, aux);
+  output(cp, end - cp, aux);
   if (c->flags & MINUS) output_dup(' ', pad_cnt, output, aux);
 }
 
+/** Writes the digits of VALUE in base B into the bytes just
+   before END, with a comma between each group of digits if GROUP
+   is true, and returns the first digit written.  Writes nothing
+   if VALUE is 0.
+
+   Dividing a 64-bit value takes a call into the compiler's
+   support routines on this 32-bit target, so values that fit in
+   32 bits are converted with native division, two decimal
+   digits at a time. */
+static char *format_digits(uintmax_t value, const struct integer_base *b, bool group, char *end) {
+  char *cp = end;
+
+  if (group) {
+    int digit_cnt = 0;
+
+    while (value > 0) {
+      if (digit_cnt > 0 && digit_cnt % b->group == 0) *--cp = ',';
+      *--cp = b->digits[value % b->base];
+      value /= b->base;
+      digit_cnt++;
+    }
+  } else if (b->base != 10) {
+    /* Base 8 or 16: the digits are fields of bits. */
+    int shift = b->base == 16 ? 4 : 3;
+
+    for (; value > 0; value >>= shift) *--cp = b->digits[value & (b->base - 1)];
+  } else {
+    unsigned long v;
+
+    for (; value > ULONG_MAX; value /= 100) {
+      cp -= 2;
+      memcpy(cp, &digit_pairs[(value % 100) * 2], 2);
+    }
+    for (v = value; v >= 10; v /= 100) {
+      cp -= 2;
+      memcpy(cp, &digit_pairs[(v % 100) * 2], 2);
+    }
+    if (v > 0) *--cp = '0' + v;
+  }
+  return cp;
+}
+
 /** Writes CH to OUTPUT with auxiliary data AUX, CNT times. */
-static void output_dup(char ch, size_t cnt, void (*output)(char, void *), void *aux) {
-  while (cnt-- > 0) output(ch, aux);
+static void output_dup(char ch, size_t cnt, void (*output)(const char *, size_t, void *), void *aux) {
+  char buf[32];
+
+  if (cnt == 0) return;
+  memset(buf, ch, cnt < sizeof buf ? cnt : sizeof buf);
+  while (cnt > 0) {
+    size_t chunk = cnt < sizeof buf ? cnt : sizeof buf;
+
+    output(buf, chunk, aux);
+    cnt -= chunk;
+  }
 }
 
 /** Formats the LENGTH characters starting at STRING according to
    the conversion specified in C.  Writes output to OUTPUT with
    auxiliary data AUX. */
-static void format_string(const char *string, int length, struct printf_conversion *c, void (*output)(char, void *), void *aux) {
-  int i;
+static void format_string(const char *string, int length, struct printf_conversion *c, void (*output)(const char *, size_t, void *), void *aux) {
   if (c->width > length && (c->flags & MINUS) == 0) output_dup(' ', c->width - length, output, aux);
-  for (i = 0; i < length; i++) output(string[i], aux);
+  if (length > 0) output(string, length, aux);
   if (c->width > length && (c->flags & MINUS) != 0) output_dup(' ', c->width - length, output, aux);
 }
 
 /** Wrapper for __vprintf() that converts varargs into a
    va_list. */
-void __printf(const char *format, void (*output)(char, void *), void *aux, ...) {
+void __printf(const char *format, void (*output)(const char *, size_t, void *), void *aux, ...) {
   va_list args;
 
   va_start(args, aux);
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <random.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 /** Converts a string representation of a signed decimal integer
@@ -40,82 +41,318 @@ static int compare_thunk(const void *a, const void *b, void *aux) {
   return (*compare)(a, b);
 }
 
+/** Partitions of at most this many elements are finished by
+   insertion sort. */
+#define INSERTION_SORT_MAX 24
+
+/** Partitions of more than this many elements take the median of
+   three medians of three as pivot, instead of a single median of
+   three. */
+#define NINTHER_MIN 128
+
+/** partial_insertion_sort() gives up after moving elements this
+   many places in total. */
+#define PARTIAL_INSERTION_LIMIT 8
+
+/** How to compare and swap the elements being sorted. */
+struct sorter {
+  size_t size;                                          /**< Bytes per element. */
+  bool words;                                           /**< Array and SIZE are word aligned? */
+  int (*compare)(const void *, const void *, void *aux); /**< Comparison function for sort(). */
+  int (*compare2)(const void *, const void *);          /**< Comparison function for qsort(), or NULL. */
+  void *aux;                                            /**< Auxiliary data for COMPARE. */
+};
+
+static void do_sort(struct sorter *, void *array, size_t cnt);
+
 /** Sorts ARRAY, which contains CNT elements of SIZE bytes each,
    using COMPARE.  When COMPARE is passed a pair of elements A
    and B, respectively, it must return a strcmp()-type result,
    i.e. less than zero if A < B, zero if A == B, greater than
-   zero if A > B.  Runs in O(n lg n) time and O(1) space in
+   zero if A > B.  Runs in O(n lg n) time and O(lg n) space in
    CNT. */
-void qsort(void *array, size_t cnt, size_t size, int (*compare)(const void *, const void *)) { sort(array, cnt, size, compare_thunk, &compare); }
+void qsort(void *array, size_t cnt, size_t size, int (*compare)(const void *, const void *)) {
+  struct sorter s;
 
-/** Swaps elements with 1-based indexes A_IDX and B_IDX in ARRAY
-   with elements of SIZE bytes each. */
-static void do_swap(unsigned char *array, size_t a_idx, size_t b_idx, size_t size) {
-  unsigned char *a = array + (a_idx - 1) * size;
-  unsigned char *b = array + (b_idx - 1) * size;
-  size_t i;
+  ASSERT(compare != NULL);
+
+  s.size = size;
+  s.compare = NULL;
+  s.compare2 = compare;
+  s.aux = NULL;
+  do_sort(&s, array, cnt);
+}
 
-  for (i = 0; i < size; i++) {
-    unsigned char t = a[i];
-    a[i] = b[i];
-    b[i] = t;
+/** Sorts ARRAY, which contains CNT elements of SIZE bytes each,
+   using COMPARE to compare elements, passing AUX as auxiliary
+   data.  When COMPARE is passed a pair of elements A and B,
+   respectively, it must return a strcmp()-type result, i.e. less
+   than zero if A < B, zero if A == B, greater than zero if A >
+   B.  Runs in O(n lg n) time and O(lg n) space in CNT.
+
+   The algorithm is Orson Peters' pattern-defeating quicksort:
+   quicksort with insertion sort for small partitions, which also notices
+   runs that are already sorted and many equal elements, and
+   falls back to heapsort if it keeps choosing bad pivots.  Sorts
+   with a fixed element type can use SORT_DEFINE in <sort.h>
+   instead, which lets the compiler inline the comparisons. */
+void sort(void *array, size_t cnt, size_t size, int (*compare)(const void *, const void *, void *aux), void *aux) {
+  struct sorter s;
+
+  ASSERT(compare != NULL);
+
+  s.size = size;
+  s.compare = compare;
+  s.compare2 = NULL;
+  s.aux = aux;
+  do_sort(&s, array, cnt);
+}
+
+/** Returns the address of the element with 0-based index IDX in
+   ARRAY, whose elements are sized as S says. */
+static inline unsigned char *elem(const struct sorter *s, unsigned char *array, size_t idx) { return array + idx * s->size; }
+
+/** Returns true if the element at A is less than the one at B
+   according to S. */
+static inline bool is_less(const struct sorter *s, const void *a, const void *b) {
+  return (s->compare2 != NULL ? s->compare2(a, b) : s->compare(a, b, s->aux)) < 0;
+}
+
+/** Swaps the elements at A and B, a word at a time if S allows. */
+static void do_swap(const struct sorter *s, void *a_, void *b_) {
+  if (s->words) {
+    unsigned long *a = a_, *b = b_;
+    size_t n;
+
+    for (n = s->size / sizeof *a; n > 0; n--) {
+      unsigned long t = *a;
+      *a++ = *b;
+      *b++ = t;
+    }
+  } else {
+    unsigned char *a = a_, *b = b_;
+    size_t n;
+
+    for (n = s->size; n > 0; n--) {
+      unsigned char t = *a;
+      *a++ = *b;
+      *b++ = t;
+    }
   }
 }
 
-/** Compares elements with 1-based indexes A_IDX and B_IDX in
-   ARRAY with elements of SIZE bytes each, using COMPARE to
-   compare elements, passing AUX as auxiliary data, and returns a
-   strcmp()-type result. */
-static int do_compare(unsigned char *array, size_t a_idx, size_t b_idx, size_t size, int (*compare)(const void *, const void *, void *aux), void *aux) {
-  return compare(array + (a_idx - 1) * size, array + (b_idx - 1) * size, aux);
+/** Swaps the elements with indexes A and B in ARRAY. */
+static inline void swap_idx(const struct sorter *s, unsigned char *array, size_t a, size_t b) { do_swap(s, elem(s, array, a), elem(s, array, b)); }
+
+/** Arranges the elements with indexes A, B, and C in ARRAY so
+   that A's is the smallest and C's the largest. */
+static void sort3(const struct sorter *s, unsigned char *array, size_t a, size_t b, size_t c) {
+  if (is_less(s, elem(s, array, b), elem(s, array, a))) swap_idx(s, array, a, b);
+  if (is_less(s, elem(s, array, c), elem(s, array, b))) {
+    swap_idx(s, array, b, c);
+    if (is_less(s, elem(s, array, b), elem(s, array, a))) swap_idx(s, array, a, b);
+  }
+}
+
+/** Sorts the CNT elements of ARRAY by insertion sort. */
+static void insertion_sort(const struct sorter *s, unsigned char *array, size_t cnt) {
+  size_t i, j;
+
+  for (i = 1; i < cnt; i++)
+    for (j = i; j > 0 && is_less(s, elem(s, array, j), elem(s, array, j - 1)); j--) swap_idx(s, array, j, j - 1);
+}
+
+/** Tries to sort the CNT elements of ARRAY by insertion sort,
+   giving up if that turns out to need much work.  Returns true
+   if ARRAY was sorted. */
+static bool partial_insertion_sort(const struct sorter *s, unsigned char *array, size_t cnt) {
+  size_t moved = 0;
+  size_t i, j;
+
+  for (i = 1; i < cnt; i++) {
+    for (j = i; j > 0 && is_less(s, elem(s, array, j), elem(s, array, j - 1)); j--) swap_idx(s, array, j, j - 1);
+    moved += i - j;
+    if (moved > PARTIAL_INSERTION_LIMIT) return false;
+  }
+  return true;
 }
 
-/** "Float down" the element with 1-based index I in ARRAY of CNT
-   elements of SIZE bytes each, using COMPARE to compare
-   elements, passing AUX as auxiliary data. */
-static void heapify(unsigned char *array, size_t i, size_t cnt, size_t size, int (*compare)(const void *, const void *, void *aux), void *aux) {
+/** "Float down" the element with 0-based index I in the heap of
+   the first CNT elements of ARRAY. */
+static void heapify(const struct sorter *s, unsigned char *array, size_t i, size_t cnt) {
   for (;;) {
     /* Set `max' to the index of the largest element among I
        and its children (if any). */
-    size_t left = 2 * i;
-    size_t right = 2 * i + 1;
+    size_t left = 2 * i + 1;
+    size_t right = 2 * i + 2;
     size_t max = i;
-    if (left <= cnt && do_compare(array, left, max, size, compare, aux) > 0) max = left;
-    if (right <= cnt && do_compare(array, right, max, size, compare, aux) > 0) max = right;
+    if (left < cnt && is_less(s, elem(s, array, max), elem(s, array, left))) max = left;
+    if (right < cnt && is_less(s, elem(s, array, max), elem(s, array, right))) max = right;
 
     /* If the maximum value is already in element I, we're
        done. */
     if (max == i) break;
 
     /* Swap and continue down the heap. */
-    do_swap(array, i, max, size);
+    swap_idx(s, array, i, max);
     i = max;
   }
 }
 
-/** Sorts ARRAY, which contains CNT elements of SIZE bytes each,
-   using COMPARE to compare elements, passing AUX as auxiliary
-   data.  When COMPARE is passed a pair of elements A and B,
-   respectively, it must return a strcmp()-type result, i.e. less
-   than zero if A < B, zero if A == B, greater than zero if A >
-   B.  Runs in O(n lg n) time and O(1) space in CNT. */
-void sort(void *array, size_t cnt, size_t size, int (*compare)(const void *, const void *, void *aux), void *aux) {
+/** Sorts the CNT elements of ARRAY by heapsort. */
+static void heap_sort(const struct sorter *s, unsigned char *array, size_t cnt) {
   size_t i;
 
-  ASSERT(array != NULL || cnt == 0);
-  ASSERT(compare != NULL);
-  ASSERT(size > 0);
-
   /* Build a heap. */
-  for (i = cnt / 2; i > 0; i--) heapify(array, i, cnt, size, compare, aux);
+  for (i = cnt / 2; i-- > 0;) heapify(s, array, i, cnt);
 
   /* Sort the heap. */
-  for (i = cnt; i > 1; i--) {
-    do_swap(array, 1, i, size);
-    heapify(array, 1, i - 1, size, compare, aux);
+  for (i = cnt; i-- > 1;) {
+    swap_idx(s, array, 0, i);
+    heapify(s, array, 0, i);
   }
 }
 
+/** Partitions the CNT elements of ARRAY around the pivot in
+   element 0, which the pivot selection guarantees is not
+   greater than some later element.  Elements less than the
+   pivot end up before it, the rest after it.  Returns the
+   pivot's new index, and sets *PARTITIONED to true if no
+   elements needed to move. */
+static size_t partition_right(const struct sorter *s, unsigned char *array, size_t cnt, bool *partitioned) {
+  const unsigned char *pivot = array;
+  size_t i = 0, j = cnt;
+
+  /* The scans need no bounds checks: they stop at the element
+     not less than the pivot, at the pivot itself, or at the
+     element just swapped. */
+  while (is_less(s, elem(s, array, ++i), pivot)) continue;
+  if (i == 1)
+    while (i < j && !is_less(s, elem(s, array, --j), pivot)) continue;
+  else
+    while (!is_less(s, elem(s, array, --j), pivot)) continue;
+
+  *partitioned = i >= j;
+  while (i < j) {
+    swap_idx(s, array, i, j);
+    while (is_less(s, elem(s, array, ++i), pivot)) continue;
+    while (!is_less(s, elem(s, array, --j), pivot)) continue;
+  }
+
+  swap_idx(s, array, 0, i - 1);
+  return i - 1;
+}
+
+/** Partitions the CNT elements of ARRAY around the pivot in
+   element 0, putting elements equal to the pivot before it and
+   greater ones after it.  Used only when no element is less than
+   the pivot.  Returns the pivot's new index. */
+static size_t partition_left(const struct sorter *s, unsigned char *array, size_t cnt) {
+  const unsigned char *pivot = array;
+  size_t i = 0, j = cnt;
+
+  while (is_less(s, pivot, elem(s, array, --j))) continue;
+  if (j + 1 == cnt)
+    while (i < j && !is_less(s, pivot, elem(s, array, ++i))) continue;
+  else
+    while (!is_less(s, pivot, elem(s, array, ++i))) continue;
+
+  while (i < j) {
+    swap_idx(s, array, i, j);
+    while (is_less(s, pivot, elem(s, array, --j))) continue;
+    while (!is_less(s, pivot, elem(s, array, ++i))) continue;
+  }
+
+  swap_idx(s, array, 0, j);
+  return j;
+}
+
+/** Sorts the CNT elements of ARRAY.  BAD_ALLOWED is the number of
+   badly unbalanced partitions to put up with before switching to
+   heapsort.  LEFTMOST is false if the element just before ARRAY
+   belongs to the same sort and is not greater than any element
+   of ARRAY. */
+static void pdq_sort(const struct sorter *s, unsigned char *array, size_t cnt, int bad_allowed, bool leftmost) {
+  while (cnt > INSERTION_SORT_MAX) {
+    size_t mid = cnt / 2;
+    size_t pivot, left_cnt, right_cnt;
+    bool partitioned;
+
+    /* Move the pivot to element 0. */
+    if (cnt > NINTHER_MIN) {
+      sort3(s, array, 0, mid, cnt - 1);
+      sort3(s, array, 1, mid - 1, cnt - 2);
+      sort3(s, array, 2, mid + 1, cnt - 3);
+      sort3(s, array, mid - 1, mid, mid + 1);
+      swap_idx(s, array, 0, mid);
+    } else
+      sort3(s, array, mid, 0, cnt - 1);
+
+    /* If the pivot equals the element before ARRAY, then no
+       element is less than the pivot.  Put all the elements
+       equal to it in place, since that is where input with many
+       repeated elements would otherwise go quadratic. */
+    if (!leftmost && !is_less(s, array - s->size, array)) {
+      pivot = partition_left(s, array, cnt);
+      array = elem(s, array, pivot + 1);
+      cnt -= pivot + 1;
+      continue;
+    }
+
+    pivot = partition_right(s, array, cnt, &partitioned);
+    left_cnt = pivot;
+    right_cnt = cnt - pivot - 1;
+
+    if (left_cnt < cnt / 8 || right_cnt < cnt / 8) {
+      /* A bad partition.  After too many, give up on quicksort.
+         Otherwise, swap a few elements around to break up
+         whatever pattern caused it. */
+      if (--bad_allowed == 0) {
+        heap_sort(s, array, cnt);
+        return;
+      }
+      if (left_cnt >= INSERTION_SORT_MAX) {
+        swap_idx(s, array, 0, left_cnt / 4);
+        swap_idx(s, array, pivot - 1, pivot - left_cnt / 4);
+      }
+      if (right_cnt >= INSERTION_SORT_MAX) {
+        swap_idx(s, array, pivot + 1, pivot + 1 + right_cnt / 4);
+        swap_idx(s, array, cnt - 1, cnt - right_cnt / 4);
+      }
+    } else if (partitioned && partial_insertion_sort(s, array, left_cnt) && partial_insertion_sort(s, elem(s, array, pivot + 1), right_cnt)) {
+      /* Already sorted, or very nearly. */
+      return;
+    }
+
+    /* Recurse into the smaller side and loop on the larger one,
+       so that the stack never gets deeper than lg CNT. */
+    if (left_cnt < right_cnt) {
+      pdq_sort(s, array, left_cnt, bad_allowed, leftmost);
+      array = elem(s, array, pivot + 1);
+      cnt = right_cnt;
+      leftmost = false;
+    } else {
+      pdq_sort(s, elem(s, array, pivot + 1), right_cnt, bad_allowed, false);
+      cnt = left_cnt;
+    }
+  }
+
+  insertion_sort(s, array, cnt);
+}
+
+/** Sorts the CNT elements of ARRAY as S says. */
+static void do_sort(struct sorter *s, void *array, size_t cnt) {
+  int bad_allowed = 0;
+  size_t n;
+
+  ASSERT(array != NULL || cnt == 0);
+  ASSERT(s->size > 0);
+
+  s->words = ((uintptr_t)array | s->size) % sizeof(unsigned long) == 0;
+  for (n = cnt; n > 1; n /= 2) bad_allowed++;
+  pdq_sort(s, array, cnt, bad_allowed, true);
+}
+
 /** Searches ARRAY, which contains CNT elements of SIZE bytes
    each, for the given KEY.  Returns a match is found, otherwise
    a null pointer.  If there are multiple matches, returns an
@@ -27,7 +27,17 @@ enum {
   SYS_MKDIR,   /**< Create a directory. */
   SYS_READDIR, /**< Reads a directory entry. */
   SYS_ISDIR,   /**< Tests if a fd represents a directory. */
-  SYS_INUMBER  /**< Returns the inode number for a fd. */
+  SYS_INUMBER, /**< Returns the inode number for a fd. */
+
+  /* Extensions. */
+  SYS_FORK,        /**< Duplicate this process. */
+  SYS_THREADSTATS, /**< Print per-thread CPU accounting. */
+  SYS_IOSTAT,      /**< Read the clock and file system I/O counters. */
+  SYS_PIPE,        /**< Create a pipe. */
+  SYS_PREAD,       /**< Read from a file at a given position. */
+  SYS_PWRITE,      /**< Write to a file at a given position. */
+  SYS_READV,       /**< Read into several buffers. */
+  SYS_WRITEV       /**< Write from several buffers. */
 };
 
 #endif /**< lib/syscall-nr.h */
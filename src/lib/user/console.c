@@ -3,6 +3,21 @@
 #include <syscall-nr.h>
 #include <syscall.h>
 
+/** Standard output is line buffered.  Text written to it by
+   printf(), puts() and putchar() collects in `stdout_buf' and
+   goes to the kernel in one write() when a new-line is added,
+   when the buffer fills up, before a read() from standard input,
+   before fork(), and at exit().  A process killed by the kernel loses any
+   partial line still in the buffer.
+
+   Output to other handles, through hprintf(), is written by the
+   end of each call. */
+static char stdout_buf[256];
+static size_t stdout_len;
+
+static void stdout_add(const char *, size_t);
+static void stdout_put(const char *, size_t);
+
 /** The standard vprintf() function,
    which is like printf() but uses a va_list. */
 int vprintf(const char *format, va_list args) { return vhprintf(STDOUT_FILENO, format, args); }
@@ -22,8 +37,8 @@ int hprintf(int handle, const char *format, ...) {
 /** Writes string S to the console, followed by a new-line
    character. */
 int puts(const char *s) {
-  write(STDOUT_FILENO, s, strlen(s));
-  putchar('\n');
+  stdout_add(s, strlen(s));
+  stdout_put("\n", 1);
 
   return 0;
 }
@@ -31,19 +46,53 @@ int puts(const char *s) {
 /** Writes C to the console. */
 int putchar(int c) {
   char c2 = c;
-  write(STDOUT_FILENO, &c2, 1);
+  stdout_put(&c2, 1);
   return c;
 }
 
-/** Auxiliary data for vhprintf_helper(). */
+/** Writes any text buffered for standard output. */
+void console_flush(void) {
+  if (stdout_len > 0) write(STDOUT_FILENO, stdout_buf, stdout_len);
+  stdout_len = 0;
+}
+
+/** Appends the N bytes in S to the standard output buffer,
+   flushing it first if they do not fit.  Text too long to
+   buffer at all is written directly. */
+static void stdout_add(const char *s, size_t n) {
+  if (stdout_len + n > sizeof stdout_buf) {
+    console_flush();
+    if (n >= sizeof stdout_buf) {
+      write(STDOUT_FILENO, s, n);
+      return;
+    }
+  }
+  memcpy(stdout_buf + stdout_len, s, n);
+  stdout_len += n;
+}
+
+/** Writes the N bytes in S to standard output, flushing the
+   buffer through the last new-line in S, if any. */
+static void stdout_put(const char *s, size_t n) {
+  size_t line = n;
+
+  while (line > 0 && s[line - 1] != '\n') line--;
+  if (line > 0) {
+    stdout_add(s, line);
+    console_flush();
+  }
+  stdout_add(s + line, n - line);
+}
+
+/** Auxiliary data for add_span(). */
 struct vhprintf_aux {
-  char buf[64]; /**< Character buffer. */
+  char buf[64]; /**< Character buffer, for handles other than standard output. */
   char *p;      /**< Current position in buffer. */
   int char_cnt; /**< Total characters written so far. */
   int handle;   /**< Output file handle. */
 };
 
-static void add_char(char, void *);
+static void add_span(const char *, size_t, void *);
 static void flush(struct vhprintf_aux *);
 
 /** Formats the printf() format specification FORMAT with
@@ -56,18 +105,31 @@ int vhprintf(int handle, const char *format, va_list args) {
       .handle = handle,
   };
 
-  __vprintf(format, args, add_char, &aux);
+  __vprintf(format, args, add_span, &aux);
   flush(&aux);
   return aux.char_cnt;
 }
 
-/** Adds C to the buffer in AUX, flushing it if the buffer fills
-   up. */
-static void add_char(char c, void *aux_) {
+/** Adds the N characters in S to standard output or to the
+   buffer in AUX, flushing the buffer if they do not fit. */
+static void add_span(const char *s, size_t n, void *aux_) {
   struct vhprintf_aux *aux = aux_;
-  *aux->p++ = c;
-  if (aux->p >= aux->buf + sizeof aux->buf) flush(aux);
-  aux->char_cnt++;
+
+  aux->char_cnt += n;
+  if (aux->handle == STDOUT_FILENO) {
+    stdout_put(s, n);
+    return;
+  }
+
+  if (aux->p + n > aux->buf + sizeof aux->buf) {
+    flush(aux);
+    if (n >= sizeof aux->buf) {
+      write(aux->handle, s, n);
+      return;
+    }
+  }
+  memcpy(aux->p, s, n);
+  aux->p += n;
 }
 
 /** Flushes the buffer in AUX. */
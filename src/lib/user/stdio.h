@@ -3,5 +3,6 @@
 
 int hprintf(int, const char *, ...) PRINTF_FORMAT(2, 3);
 int vhprintf(int, const char *, va_list) PRINTF_FORMAT(2, 0);
+void console_flush(void);
 
 #endif /**< lib/user/stdio.h */
@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <syscall.h>
 
 #include "../syscall-nr.h"
@@ -48,12 +49,30 @@
     retval;                                                                          \
   })
 
+/** Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                                       \
+  ({                                                                                                   \
+    int retval;                                                                                        \
+    asm volatile(                                                                                      \
+        "pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "                                 \
+        "pushl %[number]; int $0x30; addl $20, %%esp"                                                  \
+        : "=a"(retval)                                                                                 \
+        : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1), [arg2] "r"(ARG2), [arg3] "r"(ARG3) \
+        : "memory");                                                                                   \
+    retval;                                                                                            \
+  })
+
 void halt(void) {
+  console_flush();
   syscall0(SYS_HALT);
   NOT_REACHED();
 }
 
+/** Terminates the process with STATUS, writing any output still
+   buffered for the console first. */
 void exit(int status) {
+  console_flush();
   syscall1(SYS_EXIT, status);
   NOT_REACHED();
 }
@@ -70,7 +89,12 @@ int open(const char *file) { return syscall1(SYS_OPEN, file); }
 
 int filesize(int fd) { return syscall1(SYS_FILESIZE, fd); }
 
-int read(int fd, void *buffer, unsigned size) { return syscall3(SYS_READ, fd, buffer, size); }
+/** Reads from FD.  A prompt that printf() has buffered for the
+   console is written before reading the console. */
+int read(int fd, void *buffer, unsigned size) {
+  if (fd == STDIN_FILENO) console_flush();
+  return syscall3(SYS_READ, fd, buffer, size);
+}
 
 int write(int fd, const void *buffer, unsigned size) { return syscall3(SYS_WRITE, fd, buffer, size); }
 
@@ -93,3 +117,23 @@ bool readdir(int fd, char name[READDIR_MAX_LEN + 1]) { return syscall2(SYS_READD
 bool isdir(int fd) { return syscall1(SYS_ISDIR, fd); }
 
 int inumber(int fd) { return syscall1(SYS_INUMBER, fd); }
+
+pid_t fork(void) {
+  /* Otherwise both processes would print the buffered text. */
+  console_flush();
+  return (pid_t)syscall0(SYS_FORK);
+}
+
+void threadstats(void) { syscall0(SYS_THREADSTATS); }
+
+void iostat(struct iostat *st) { syscall1(SYS_IOSTAT, st); }
+
+bool pipe(int fds[2]) { return syscall1(SYS_PIPE, fds); }
+
+int pread(int fd, void *buffer, unsigned size, unsigned offset) { return syscall4(SYS_PREAD, fd, buffer, size, offset); }
+
+int pwrite(int fd, const void *buffer, unsigned size, unsigned offset) { return syscall4(SYS_PWRITE, fd, buffer, size, offset); }
+
+int readv(int fd, const struct iovec *iov, int iovcnt) { return syscall3(SYS_READV, fd, iov, iovcnt); }
+
+int writev(int fd, const struct iovec *iov, int iovcnt) { return syscall3(SYS_WRITEV, fd, iov, iovcnt); }
@@ -3,6 +3,7 @@
 
 #include <debug.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /** Process identifier. */
 typedef int pid_t;
@@ -12,9 +13,25 @@ typedef int pid_t;
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) - 1)
 
+/** A buffer for readv() and writev(). */
+struct iovec {
+  void *iov_base; /**< Start of buffer. */
+  size_t iov_len; /**< Size of buffer in bytes. */
+};
+
+/** Most iovecs that readv() and writev() accept at once. */
+#define IOV_MAX 64
+
 /** Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/** Snapshot returned by iostat(). */
+struct iostat {
+  long long now_ns;             /**< Nanoseconds since boot. */
+  unsigned long long read_cnt;  /**< Sectors read from the file system device. */
+  unsigned long long write_cnt; /**< Sectors written to the file system device. */
+};
+
 /** Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0 /**< Successful execution. */
 #define EXIT_FAILURE 1 /**< Unsuccessful execution. */
@@ -45,4 +62,14 @@ bool readdir(int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir(int fd);
 int inumber(int fd);
 
+/** Extensions. */
+pid_t fork(void);
+void threadstats(void);
+void iostat(struct iostat *);
+bool pipe(int fds[2]);
+int pread(int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite(int fd, const void *buffer, unsigned length, unsigned offset);
+int readv(int fd, const struct iovec *, int iovcnt);
+int writev(int fd, const struct iovec *, int iovcnt);
+
 #endif /**< lib/user/syscall.h */
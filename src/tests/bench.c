@@ -0,0 +1,43 @@
+#include "tests/bench.h"
+
+#include <sort.h>
+#include <stdio.h>
+
+/* Defined by tests/threads/tests.c in the kernel and by
+   tests/lib.c in user programs, whose headers cannot be included
+   in each other's builds. */
+void msg(const char *, ...);
+void fail(const char *, ...);
+
+/** Reports that METRIC measured VALUE, in UNIT. */
+void bench_report(const char *metric, int64_t value, const char *unit) { msg("bench %s %lld %s", metric, value, unit); }
+
+#define SAMPLE_LESS(A, B) (*(A) < *(B))
+SORT_DEFINE(sort_samples, int64_t, SAMPLE_LESS)
+
+/** Sorts the CNT nanosecond SAMPLES and reports their mean, median,
+   90th and 99th percentiles, and maximum as METRIC.mean,
+   METRIC.p50, and so on. */
+void bench_summary(const char *metric, int64_t samples[], size_t cnt) {
+  static const struct {
+    const char *name;
+    int permille;
+  } points[] = {{"p50", 500}, {"p90", 900}, {"p99", 990}, {"max", 1000}};
+  char name[64];
+  int64_t sum = 0;
+  size_t i;
+
+  if (cnt == 0) fail("%s: no samples", metric);
+
+  sort_samples(samples, cnt);
+  for (i = 0; i < cnt; i++) sum += samples[i];
+  snprintf(name, sizeof name, "%s.mean", metric);
+  bench_report(name, sum / (int64_t)cnt, "ns");
+
+  for (i = 0; i < sizeof points / sizeof *points; i++) {
+    size_t idx = (cnt * points[i].permille + 999) / 1000;
+
+    snprintf(name, sizeof name, "%s.%s", metric, points[i].name);
+    bench_report(name, samples[idx > 0 ? idx - 1 : 0], "ns");
+  }
+}
@@ -0,0 +1,18 @@
+#ifndef TESTS_BENCH_H
+#define TESTS_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Benchmark results are printed by msg() as lines of the form
+     (TEST) bench METRIC VALUE UNIT
+   which check_bench() in tests/tests.pm collects into TEST.bench,
+   and tests/make-bench compares against a stored baseline.
+
+   Kernel and user benchmarks both report through these
+   functions, so they agree on the format. */
+
+void bench_report(const char *metric, int64_t value, const char *unit);
+void bench_summary(const char *metric, int64_t samples[], size_t cnt);
+
+#endif /**< tests/bench.h */
@@ -0,0 +1,83 @@
+/** Measures aggregate throughput when 1, 2, and 4 processes each
+   write and then read back a file of their own at the same
+   time, all contending for the file system.
+
+   The children are forked and made ready before the clock
+   starts, and then all released at once through a pipe, so that
+   the time measured is that of the file system work rather than
+   of creating processes. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/filesys/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+#define CHILD_FILE_SIZE (64 * 1024)
+#define CHILD_REQUEST_SIZE 4096
+
+static char buf[CHILD_REQUEST_SIZE];
+
+/** Runs child CHILD_IDX: once a byte arrives on GATE, writes and
+   then reads back file "cN", where N is CHILD_IDX, and exits
+   with CHILD_IDX as its status. */
+static void run_child(size_t child_idx, int gate) {
+  char name[16];
+  size_t ofs;
+  char go;
+  int fd;
+
+  quiet = true;
+  snprintf(name, sizeof name, "c%zu", child_idx);
+  random_init(child_idx);
+  random_bytes(buf, sizeof buf);
+  CHECK((fd = open(name)) > 1, "open \"%s\"", name);
+  CHECK(read(gate, &go, 1) == 1, "wait for start");
+
+  for (ofs = 0; ofs < CHILD_FILE_SIZE; ofs += sizeof buf) CHECK(write(fd, buf, sizeof buf) == (int)sizeof buf, "write \"%s\" at %zu", name, ofs);
+  seek(fd, 0);
+  for (ofs = 0; ofs < CHILD_FILE_SIZE; ofs += sizeof buf) CHECK(read(fd, buf, sizeof buf) == (int)sizeof buf, "read \"%s\" at %zu", name, ofs);
+  close(fd);
+  exit(child_idx);
+}
+
+void test_main(void) {
+  static const char go[CHILD_CNT];
+  pid_t children[CHILD_CNT];
+  size_t child_cnt;
+  size_t i;
+
+  for (i = 0; i < CHILD_CNT; i++) {
+    char name[16];
+
+    snprintf(name, sizeof name, "c%zu", i);
+    CHECK(create(name, CHILD_FILE_SIZE), "create \"%s\"", name);
+  }
+
+  for (child_cnt = 1; child_cnt <= CHILD_CNT; child_cnt *= 2) {
+    struct bench b;
+    char metric[64];
+    int gate[2];
+
+    CHECK(pipe(gate), "pipe");
+    for (i = 0; i < child_cnt; i++) {
+      children[i] = fork();
+      if (children[i] == PID_ERROR) fail("fork child %zu of %zu", i + 1, child_cnt);
+      if (children[i] == 0) {
+        close(gate[1]);
+        run_child(i, gate[0]);
+      }
+    }
+    close(gate[0]);
+
+    snprintf(metric, sizeof metric, "contend.%zu", child_cnt);
+    bench_start(&b);
+    if (write(gate[1], go, child_cnt) != (int)child_cnt) fail("start %zu children", child_cnt);
+    wait_children(children, child_cnt);
+    bench_throughput(&b, metric, child_cnt * 2 * CHILD_FILE_SIZE);
+    close(gate[1]);
+  }
+}
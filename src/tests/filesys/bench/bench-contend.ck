@@ -0,0 +1,5 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench (map { ($_, "$_.amp", "$_.sectors_read", "$_.sectors_written") } 'contend.1', 'contend.2', 'contend.4');
@@ -0,0 +1,69 @@
+/** Measures how lookups scale with the number of entries in a
+   directory.  Fills the root directory with empty files, up to
+   MAX_ENTRIES or until the file system refuses another one, and
+   times LOOKUP_CNT random lookups each time the entry count
+   reaches a power of 10, and again at the end. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/filesys/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define MAX_ENTRIES 10000
+#define LOOKUP_CNT 100
+
+/** Writes the name of file I into NAME. */
+static void file_name(char name[16], int i) { snprintf(name, 16, "d%d", i); }
+
+/** Times LOOKUP_CNT lookups of random files among the first
+   ENTRY_CNT, and reports them as dir.lookup.SUFFIX. */
+static void time_lookups(int entry_cnt, const char *suffix) {
+  struct bench b;
+  char metric[64];
+  int i;
+
+  snprintf(metric, sizeof metric, "dir.lookup.%s", suffix);
+  bench_start(&b);
+  for (i = 0; i < LOOKUP_CNT; i++) {
+    char name[16];
+    int fd;
+
+    file_name(name, random_ulong() % entry_cnt);
+    if ((fd = open(name)) < 2) fail("open \"%s\"", name);
+    close(fd);
+  }
+  bench_rate(&b, metric, LOOKUP_CNT);
+}
+
+void test_main(void) {
+  int entry_cnt, next_power = 10;
+  struct bench b;
+  char name[16];
+  int i;
+
+  bench_start(&b);
+  for (entry_cnt = 0; entry_cnt < MAX_ENTRIES; entry_cnt++) {
+    file_name(name, entry_cnt);
+    if (!create(name, 0)) break;
+    if (entry_cnt + 1 == next_power) {
+      char suffix[16];
+
+      snprintf(suffix, sizeof suffix, "%d", next_power);
+      time_lookups(next_power, suffix);
+      next_power *= 10;
+    }
+  }
+  bench_report("dir.entries", entry_cnt, "entries");
+  if (entry_cnt == 0) fail("could not create any files");
+  time_lookups(entry_cnt, "max");
+
+  bench_start(&b);
+  for (i = 0; i < entry_cnt; i++) {
+    file_name(name, i);
+    if (!remove(name)) fail("remove \"%s\"", name);
+  }
+  bench_rate(&b, "dir.remove", entry_cnt);
+}
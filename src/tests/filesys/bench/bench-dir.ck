@@ -0,0 +1,5 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('dir.entries', 'dir.remove', 'dir.lookup.10', 'dir.lookup.max');
@@ -0,0 +1,70 @@
+/** Measures how many small files can be created, looked up, and
+   removed per second, and the sectors each kind of operation
+   reads and writes.  Works in batches of BATCH_CNT files so as
+   to fit in a directory of fixed size. */
+
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/filesys/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BATCH_CNT 10
+#define ROUND_CNT 20
+#define FILE_SIZE 512
+
+enum meta_op { META_CREATE, META_OPEN, META_REMOVE, META_CNT };
+
+static const char *op_names[META_CNT] = {"meta.create", "meta.open", "meta.remove"};
+
+/** Does OP on file I of the batch. */
+static void do_op(enum meta_op op, int i) {
+  char name[16];
+  int fd;
+
+  snprintf(name, sizeof name, "m%d", i);
+  switch (op) {
+    case META_CREATE:
+      if (!create(name, FILE_SIZE)) fail("create \"%s\"", name);
+      break;
+    case META_OPEN:
+      if ((fd = open(name)) < 2) fail("open \"%s\"", name);
+      close(fd);
+      break;
+    case META_REMOVE:
+      if (!remove(name)) fail("remove \"%s\"", name);
+      break;
+    default:
+      NOT_REACHED();
+  }
+}
+
+void test_main(void) {
+  struct iostat total[META_CNT] = {{0, 0, 0}};
+  int round, op, i;
+
+  /* Time each kind of operation separately, batch by batch, and
+     report the totals. */
+  for (round = 0; round < ROUND_CNT; round++)
+    for (op = 0; op < META_CNT; op++) {
+      struct iostat before, after;
+
+      iostat(&before);
+      for (i = 0; i < BATCH_CNT; i++) do_op(op, i);
+      iostat(&after);
+      total[op].now_ns += after.now_ns - before.now_ns;
+      total[op].read_cnt += after.read_cnt - before.read_cnt;
+      total[op].write_cnt += after.write_cnt - before.write_cnt;
+    }
+
+  for (op = 0; op < META_CNT; op++) {
+    char name[64];
+
+    bench_report(op_names[op], BATCH_CNT * ROUND_CNT * 1000000000LL / (total[op].now_ns > 0 ? total[op].now_ns : 1), "op/s");
+    snprintf(name, sizeof name, "%s.sectors_read", op_names[op]);
+    bench_report(name, total[op].read_cnt, "sectors");
+    snprintf(name, sizeof name, "%s.sectors_written", op_names[op]);
+    bench_report(name, total[op].write_cnt, "sectors");
+  }
+}
@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench (map { ($_, "$_.sectors_read", "$_.sectors_written") }
+	     'meta.create', 'meta.open', 'meta.remove');
@@ -0,0 +1,53 @@
+/** Measures random write and read throughput within a file of
+   FILE_SIZE bytes at several request sizes. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/filesys/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (256 * 1024)
+#define OP_CNT 256
+
+static const char file_name[] = "random";
+static const size_t request_sizes[] = {512, 4096, 16384};
+
+static char buf[16384];
+
+/** Writes or reads OP_CNT requests of REQUEST_SIZE bytes each, at
+   random REQUEST_SIZE-aligned offsets in FD, and reports the
+   throughput as METRIC. */
+static void transfer(int fd, bool writing, size_t request_size) {
+  struct bench b;
+  char metric[64];
+  int i;
+
+  snprintf(metric, sizeof metric, "random.%s.%zu", writing ? "write" : "read", request_size);
+  bench_start(&b);
+  for (i = 0; i < OP_CNT; i++) {
+    size_t ofs = random_ulong() % (FILE_SIZE / request_size) * request_size;
+    int n;
+
+    seek(fd, ofs);
+    n = writing ? write(fd, buf, request_size) : read(fd, buf, request_size);
+    if (n != (int)request_size) fail("%s: %d bytes at offset %zu, expected %zu", metric, n, ofs, request_size);
+  }
+  bench_throughput(&b, metric, OP_CNT * request_size);
+}
+
+void test_main(void) {
+  size_t i;
+  int fd;
+
+  random_bytes(buf, sizeof buf);
+  CHECK(create(file_name, FILE_SIZE), "create \"%s\"", file_name);
+  CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+  for (i = 0; i < sizeof request_sizes / sizeof *request_sizes; i++) {
+    transfer(fd, true, request_sizes[i]);
+    transfer(fd, false, request_sizes[i]);
+  }
+  close(fd);
+}
@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench (map { ($_, "$_.amp", "$_.sectors_read", "$_.sectors_written") }
+	     map { ("random.write.$_", "random.read.$_") } 512, 4096, 16384);
@@ -0,0 +1,48 @@
+/** Measures sequential write and read throughput through a file
+   of FILE_SIZE bytes at several request sizes. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/filesys/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (256 * 1024)
+
+static const char file_name[] = "seq";
+static const size_t request_sizes[] = {512, 4096, 16384, 65536};
+
+static char buf[65536];
+
+/** Writes or reads all of FD sequentially, REQUEST_SIZE bytes at
+   a time, and reports the throughput as METRIC. */
+static void transfer(int fd, bool writing, size_t request_size) {
+  struct bench b;
+  char metric[64];
+  size_t ofs;
+
+  snprintf(metric, sizeof metric, "seq.%s.%zu", writing ? "write" : "read", request_size);
+  seek(fd, 0);
+  bench_start(&b);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += request_size) {
+    int n = writing ? write(fd, buf, request_size) : read(fd, buf, request_size);
+    if (n != (int)request_size) fail("%s: %d bytes at offset %zu, expected %zu", metric, n, ofs, request_size);
+  }
+  bench_throughput(&b, metric, FILE_SIZE);
+}
+
+void test_main(void) {
+  size_t i;
+  int fd;
+
+  random_bytes(buf, sizeof buf);
+  CHECK(create(file_name, FILE_SIZE), "create \"%s\"", file_name);
+  CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+  for (i = 0; i < sizeof request_sizes / sizeof *request_sizes; i++) {
+    transfer(fd, true, request_sizes[i]);
+    transfer(fd, false, request_sizes[i]);
+  }
+  close(fd);
+}
@@ -0,0 +1,47 @@
+#include "tests/filesys/bench/bench.h"
+
+#include <stdio.h>
+
+/** Starts timing B. */
+void bench_start(struct bench *b) { iostat(&b->start); }
+
+/** Reports the sectors that the work timed by B read and wrote as
+   METRIC.sectors_read and METRIC.sectors_written, and returns
+   the nanoseconds it took, at least 1. */
+static long long report_io(const struct bench *b, const char *metric, unsigned long long *sectors) {
+  struct iostat end;
+  char name[64];
+
+  iostat(&end);
+  snprintf(name, sizeof name, "%s.sectors_read", metric);
+  bench_report(name, end.read_cnt - b->start.read_cnt, "sectors");
+  snprintf(name, sizeof name, "%s.sectors_written", metric);
+  bench_report(name, end.write_cnt - b->start.write_cnt, "sectors");
+
+  *sectors = (end.read_cnt - b->start.read_cnt) + (end.write_cnt - b->start.write_cnt);
+  return end.now_ns > b->start.now_ns ? end.now_ns - b->start.now_ns : 1;
+}
+
+/** Reports the work timed by B, which moved BYTES bytes, as
+   METRIC in kB/s, along with the sectors it read and wrote and
+   METRIC.amp, the bytes those sectors hold as a percentage of
+   BYTES. */
+void bench_throughput(const struct bench *b, const char *metric, size_t bytes) {
+  unsigned long long sectors;
+  long long ns = report_io(b, metric, &sectors);
+  char name[64];
+
+  bench_report(metric, bytes * 1000000000ULL / 1024 / ns, "kB/s");
+  snprintf(name, sizeof name, "%s.amp", metric);
+  bench_report(name, bytes > 0 ? sectors * 512 * 100 / bytes : 0, "%");
+}
+
+/** Reports the work timed by B, which did OPS operations, as
+   METRIC in operations per second, along with the sectors it
+   read and wrote. */
+void bench_rate(const struct bench *b, const char *metric, size_t ops) {
+  unsigned long long sectors;
+  long long ns = report_io(b, metric, &sectors);
+
+  bench_report(metric, ops * 1000000000ULL / ns, "op/s");
+}
@@ -0,0 +1,18 @@
+#ifndef TESTS_FILESYS_BENCH_BENCH_H
+#define TESTS_FILESYS_BENCH_BENCH_H
+
+#include <stddef.h>
+#include <syscall.h>
+
+#include "tests/bench.h"
+
+/** A timed stretch of file system work. */
+struct bench {
+  struct iostat start; /**< Clock and sector counts at bench_start(). */
+};
+
+void bench_start(struct bench *);
+void bench_throughput(const struct bench *, const char *metric, size_t bytes);
+void bench_rate(const struct bench *, const char *metric, size_t ops);
+
+#endif /**< tests/filesys/bench/bench.h */
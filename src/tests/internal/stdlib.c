@@ -11,6 +11,7 @@
 #include <debug.h>
 #include <limits.h>
 #include <random.h>
+#include <sort.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -24,6 +25,9 @@ static int compare_ints(const void *, const void *);
 static void verify_order(const int[], size_t);
 static void verify_bsearch(const int[], size_t);
 
+#define INT_LESS(A, B) (*(A) < *(B))
+SORT_DEFINE(sort_ints, int, INT_LESS)
+
 /** Test sorting and searching implementations. */
 void test(void) {
   int cnt;
@@ -45,6 +49,14 @@ void test(void) {
       qsort(values, cnt, sizeof *values, compare_ints);
       verify_order(values, cnt);
       verify_bsearch(values, cnt);
+
+      /* The same with reversed input and the typed variant. */
+      for (i = 0; i < cnt; i++) values[i] = cnt - 1 - i;
+      qsort(values, cnt, sizeof *values, compare_ints);
+      verify_order(values, cnt);
+      shuffle(values, cnt);
+      sort_ints(values, cnt);
+      verify_order(values, cnt);
     }
   }
 
@@ -55,6 +55,46 @@ sub common_checks {
       if !grep (/Powering off/, @output);
 }
 
+# Checks the output of a benchmark: that it ran cleanly, between
+# "begin" and "end", and reported each metric in @METRICS, as lines
+# of the form "(TEST) bench METRIC VALUE UNIT".  Writes the metrics,
+# one "TEST METRIC VALUE UNIT" per line, to TEST.bench, for
+# tests/make-bench to compare against a baseline, along with the
+# whole run's sector counts from block_print_stats() as metrics
+# named block.ROLE.reads and block.ROLE.writes.
+sub check_bench {
+    my (@metrics) = @_;
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+
+    my ($name) = $test =~ m%([^/]+)$%;
+    fail "missing 'begin' message\n"
+      if !grep ($_ eq "($name) begin", @output);
+    fail "missing 'end' message\n"
+      if !grep ($_ eq "($name) end", @output);
+
+    my (%results);
+    foreach (@output) {
+	my ($metric, $value, $unit)
+	  = /^\(\Q$name\E\) bench (\S+) (-?\d+) (\S+)$/ or next;
+	$results{$metric} = "$value $unit";
+    }
+    foreach (@output) {
+	my ($role, $reads, $writes)
+	  = /^\S+ \((\S+)\): (\d+) reads, (\d+) writes$/ or next;
+	$results{"block.$role.reads"} = "$reads sectors";
+	$results{"block.$role.writes"} = "$writes sectors";
+    }
+    foreach my $metric (@metrics) {
+	fail "missing result for $metric\n" if !defined $results{$metric};
+    }
+
+    open (BENCH, '>', "$test.bench") or die "$test.bench: create: $!\n";
+    print BENCH "$test $_ $results{$_}\n" foreach sort keys %results;
+    close (BENCH);
+    pass;
+}
+
 sub check_for_panic {
     my ($run, @output) = @_;
 
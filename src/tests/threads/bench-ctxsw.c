@@ -0,0 +1,61 @@
+/** Measures the cost of a context switch, two ways: two threads
+   at equal priority handing control back and forth through a pair
+   of semaphores, and two threads calling thread_yield() in turn.
+   Each round trip is two switches. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** Round trips to time. */
+#define ROUND_TRIPS 10000
+
+static struct semaphore ping, pong;
+static volatile bool stop;
+
+/** Answers each ping with a pong. */
+static void ponger(void *aux UNUSED) {
+  int i;
+
+  for (i = 0; i < ROUND_TRIPS; i++) {
+    sema_down(&ping);
+    sema_up(&pong);
+  }
+}
+
+/** Yields until told to stop. */
+static void yielder(void *aux UNUSED) {
+  while (!stop) thread_yield();
+  sema_up(&pong);
+}
+
+void test_bench_ctxsw(void) {
+  int64_t start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT(!thread_mlfqs());
+
+  sema_init(&ping, 0);
+  sema_init(&pong, 0);
+  thread_create("ponger", PRI_DEFAULT, ponger, NULL);
+  start = timer_now_ns();
+  for (i = 0; i < ROUND_TRIPS; i++) {
+    sema_up(&ping);
+    sema_down(&pong);
+  }
+  bench_report("ctxsw.sema", (timer_now_ns() - start) / (2 * ROUND_TRIPS), "ns");
+
+  stop = false;
+  thread_create("yielder", PRI_DEFAULT, yielder, NULL);
+  start = timer_now_ns();
+  for (i = 0; i < ROUND_TRIPS; i++) thread_yield();
+  bench_report("ctxsw.yield", (timer_now_ns() - start) / (2 * ROUND_TRIPS), "ns");
+  stop = true;
+  sema_down(&pong);
+}
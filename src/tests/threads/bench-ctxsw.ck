@@ -0,0 +1,5 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('ctxsw.sema', 'ctxsw.yield');
@@ -0,0 +1,76 @@
+/** Measures lock handoff latency through priority donation chains
+   of increasing depth.
+
+   As in priority-donate-chain, the main thread drops to PRI_MIN
+   and acquires lock 0, then creates threads 1...DEPTH at rising
+   priorities.  Thread i acquires lock i (except the last one) and
+   then blocks on lock i - 1, donating its priority down the chain.
+   The main thread then releases lock 0, and the chain unwinds one
+   handoff at a time until thread DEPTH acquires lock DEPTH - 1.
+   The time from the release to that acquisition is one sample. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** Deepest chain measured. */
+#define DEPTH_MAX 8
+
+/** Samples at each depth. */
+#define REPEAT_CNT 50
+
+static struct lock locks[DEPTH_MAX];
+static struct semaphore exited;
+static int chain_depth;
+static int64_t start, end;
+
+/** Thread I in the chain, where I is cast to a pointer. */
+static void donor(void *aux) {
+  int i = (int)aux;
+  bool last = i == chain_depth;
+
+  if (!last) lock_acquire(&locks[i]);
+  lock_acquire(&locks[i - 1]);
+  if (last) end = timer_now_ns();
+  lock_release(&locks[i - 1]);
+  if (!last) lock_release(&locks[i]);
+  sema_up(&exited);
+}
+
+/** Returns the time for a chain of DEPTH handoffs to unwind. */
+static int64_t unwind(int depth) {
+  int i;
+
+  chain_depth = depth;
+  lock_acquire(&locks[0]);
+  for (i = 1; i <= depth; i++) thread_create("donor", PRI_MIN + i, donor, (void *)i);
+  start = timer_now_ns();
+  lock_release(&locks[0]);
+  for (i = 1; i <= depth; i++) sema_down(&exited);
+  return end - start;
+}
+
+void test_bench_lock_chain(void) {
+  static int64_t samples[REPEAT_CNT];
+  int depth, i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT(!thread_mlfqs());
+
+  thread_set_priority(PRI_MIN);
+  for (i = 0; i < DEPTH_MAX; i++) lock_init(&locks[i]);
+  sema_init(&exited, 0);
+
+  for (depth = 1; depth <= DEPTH_MAX; depth *= 2) {
+    char metric[32];
+
+    for (i = 0; i < REPEAT_CNT; i++) samples[i] = unwind(depth);
+    snprintf(metric, sizeof metric, "lock.chain%d", depth);
+    bench_summary(metric, samples, REPEAT_CNT);
+  }
+}
@@ -0,0 +1,5 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench (map { my $depth = $_; map ("lock.chain$depth.$_", qw (mean p50 p90 p99 max)) } 1, 2, 4, 8);
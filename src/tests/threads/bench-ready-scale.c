@@ -0,0 +1,56 @@
+/** Measures how the cost of a context switch grows with the
+   length of the ready queue.  For each thread count N, N threads
+   at the main thread's priority call thread_yield() in a loop, so
+   that each yield by the main thread cycles through all of them.
+
+   Run with enough memory for 500 thread pages; see Make.tests. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** Switches to time at each thread count. */
+#define SWITCH_CNT 20000
+
+static volatile bool stop;
+static struct semaphore exited;
+
+/** Yields until told to stop. */
+static void yielder(void *aux UNUSED) {
+  while (!stop) thread_yield();
+  sema_up(&exited);
+}
+
+void test_bench_ready_scale(void) {
+  static const int thread_cnts[] = {1, 10, 100, 500};
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT(!thread_mlfqs());
+
+  sema_init(&exited, 0);
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++) {
+    int thread_cnt = thread_cnts[i];
+    int yields = SWITCH_CNT / (thread_cnt + 1) + 1;
+    char metric[32];
+    int64_t start;
+    int j;
+
+    stop = false;
+    for (j = 0; j < thread_cnt; j++)
+      if (thread_create("yielder", PRI_DEFAULT, yielder, NULL) == TID_ERROR) fail("could not create thread %d of %d", j + 1, thread_cnt);
+
+    start = timer_now_ns();
+    for (j = 0; j < yields; j++) thread_yield();
+    snprintf(metric, sizeof metric, "ready.%d", thread_cnt);
+    bench_report(metric, (timer_now_ns() - start) / ((int64_t)yields * (thread_cnt + 1)), "ns");
+
+    stop = true;
+    for (j = 0; j < thread_cnt; j++) sema_down(&exited);
+  }
+}
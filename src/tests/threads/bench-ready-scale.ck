@@ -0,0 +1,5 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('ready.1', 'ready.10', 'ready.100', 'ready.500');
@@ -0,0 +1,108 @@
+/** Measures the open-addressing hash table in lib/kernel/rhash.c
+   against the chained hash table in lib/kernel/hash.c.  Each
+   inserts KEY_CNT keys, looks each one up along with as many
+   absent keys, and then deletes them all, for a range of
+   KEY_CNT.  Reports the mean time per operation. */
+
+#include <hash.h>
+#include <rhash.h>
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+
+/** Largest number of keys. */
+#define MAX_KEYS 4096
+
+/** An element that can be in both kinds of table. */
+struct value {
+  struct hash_elem h_elem;  /**< Element in a struct hash. */
+  struct rhash_elem r_elem; /**< Element in a struct rhash. */
+  int key;                  /**< Key. */
+};
+
+static struct value values[MAX_KEYS];
+
+static int64_t time_hash(int key_cnt);
+static int64_t time_rhash(int key_cnt);
+static unsigned value_hash(const struct hash_elem *, void *);
+static bool value_less(const struct hash_elem *, const struct hash_elem *, void *);
+static unsigned value_rhash(const struct rhash_elem *, void *);
+static bool value_rless(const struct rhash_elem *, const struct rhash_elem *, void *);
+
+void test_bench_rhash(void) {
+  int key_cnt;
+  int i;
+
+  for (i = 0; i < MAX_KEYS; i++) values[i].key = i;
+
+  for (key_cnt = 64; key_cnt <= MAX_KEYS; key_cnt *= 8) {
+    char name[32];
+
+    snprintf(name, sizeof name, "rhash.%d.hash", key_cnt);
+    bench_report(name, time_hash(key_cnt), "ns");
+    snprintf(name, sizeof name, "rhash.%d.rhash", key_cnt);
+    bench_report(name, time_rhash(key_cnt), "ns");
+  }
+}
+
+/** Inserts KEY_CNT keys into a struct hash, looks each one up
+   along with as many absent keys, then deletes them all.
+   Returns the mean time per operation in nanoseconds. */
+static int64_t time_hash(int key_cnt) {
+  struct hash h;
+  struct value key;
+  int64_t start;
+  int i;
+
+  if (!hash_init(&h, value_hash, value_less, NULL)) fail("out of memory");
+  start = timer_now_ns();
+  for (i = 0; i < key_cnt; i++) hash_insert(&h, &values[i].h_elem);
+  for (i = 0; i < 2 * key_cnt; i++) {
+    key.key = i;
+    if ((hash_find(&h, &key.h_elem) != NULL) != (i < key_cnt)) fail("hash_find() of key %d is wrong", i);
+  }
+  for (i = 0; i < key_cnt; i++) hash_delete(&h, &values[i].h_elem);
+  start = timer_now_ns() - start;
+  hash_destroy(&h, NULL);
+
+  return start / (4 * key_cnt);
+}
+
+/** Like time_hash(), for a struct rhash. */
+static int64_t time_rhash(int key_cnt) {
+  struct rhash h;
+  struct value key;
+  int64_t start;
+  int i;
+
+  if (!rhash_init(&h, value_rhash, value_rless, NULL)) fail("out of memory");
+  start = timer_now_ns();
+  for (i = 0; i < key_cnt; i++) rhash_insert(&h, &values[i].r_elem);
+  for (i = 0; i < 2 * key_cnt; i++) {
+    key.key = i;
+    if ((rhash_find(&h, &key.r_elem) != NULL) != (i < key_cnt)) fail("rhash_find() of key %d is wrong", i);
+  }
+  for (i = 0; i < key_cnt; i++) rhash_delete(&h, &values[i].r_elem);
+  start = timer_now_ns() - start;
+  rhash_destroy(&h, NULL);
+
+  return start / (4 * key_cnt);
+}
+
+/** Returns a hash value for the key of E. */
+static unsigned value_hash(const struct hash_elem *e, void *aux UNUSED) { return hash_int(hash_entry(e, struct value, h_elem)->key); }
+
+/** Returns true if the key of A is less than that of B. */
+static bool value_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+  return hash_entry(a, struct value, h_elem)->key < hash_entry(b, struct value, h_elem)->key;
+}
+
+/** Returns a hash value for the key of E. */
+static unsigned value_rhash(const struct rhash_elem *e, void *aux UNUSED) { return hash_int(rhash_entry(e, struct value, r_elem)->key); }
+
+/** Returns true if the key of A is less than that of B. */
+static bool value_rless(const struct rhash_elem *a, const struct rhash_elem *b, void *aux UNUSED) {
+  return rhash_entry(a, struct value, r_elem)->key < rhash_entry(b, struct value, r_elem)->key;
+}
@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('rhash.64.hash', 'rhash.64.rhash', 'rhash.512.hash', 'rhash.512.rhash',
+	     'rhash.4096.hash', 'rhash.4096.rhash');
@@ -0,0 +1,49 @@
+/** Measures how far sleeps overshoot or undershoot what was asked
+   for: timer_sleep() of one tick, starting on a tick boundary, and
+   timer_usleep() of less than a tick. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/** Sleeps to time of each kind. */
+#define SLEEP_CNT 100
+
+/** Sub-tick sleep length, in microseconds. */
+#define USLEEP_US 500
+
+/** Returns the absolute value of X. */
+static int64_t abs64(int64_t x) { return x < 0 ? -x : x; }
+
+void test_bench_sleep(void) {
+  int64_t *samples = malloc(SLEEP_CNT * sizeof *samples);
+  int64_t start, end;
+  int i;
+
+  if (samples == NULL) fail("out of memory");
+
+  /* Start on a tick boundary, so that each timer_sleep(1) should
+     take exactly one tick. */
+  timer_sleep(1);
+  start = timer_now_ns();
+  for (i = 0; i < SLEEP_CNT; i++) {
+    timer_sleep(1);
+    end = timer_now_ns();
+    samples[i] = abs64(end - start - 1000000000 / TIMER_FREQ);
+    start = end;
+  }
+  bench_summary("sleep.tick_jitter", samples, SLEEP_CNT);
+
+  for (i = 0; i < SLEEP_CNT; i++) {
+    start = timer_now_ns();
+    timer_usleep(USLEEP_US);
+    samples[i] = abs64(timer_now_ns() - start - USLEEP_US * 1000);
+  }
+  bench_summary("sleep.usleep_jitter", samples, SLEEP_CNT);
+
+  free(samples);
+}
@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('sleep.tick_jitter.mean', 'sleep.tick_jitter.p50', 'sleep.tick_jitter.p90', 'sleep.tick_jitter.p99', 'sleep.tick_jitter.max',
+	     'sleep.usleep_jitter.mean', 'sleep.usleep_jitter.p50', 'sleep.usleep_jitter.p90', 'sleep.usleep_jitter.p99', 'sleep.usleep_jitter.max');
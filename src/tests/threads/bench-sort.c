@@ -0,0 +1,102 @@
+/** Measures sorting SORT_CNT ints with qsort(), which calls its
+   comparison function through a pointer, and with a function made
+   by SORT_DEFINE, which inlines it.  Inputs are random, already
+   sorted, reversed, and random with only a few distinct values. */
+
+#include <random.h>
+#include <sort.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+/** Number of elements to sort. */
+#define SORT_CNT 8192
+
+/** Sorts of each kind to average over. */
+#define REPEAT 4
+
+#define INT_LESS(A, B) (*(A) < *(B))
+SORT_DEFINE(sort_ints, int, INT_LESS)
+
+/** Input patterns. */
+enum pattern { RANDOM, SORTED, REVERSED, FEW_VALUES, PATTERN_CNT };
+
+static const char *pattern_names[PATTERN_CNT] = {"random", "sorted", "reversed", "few"};
+
+/** Compares two ints for qsort(). */
+static int compare_ints(const void *a_, const void *b_) {
+  const int *a = a_;
+  const int *b = b_;
+
+  return *a < *b ? -1 : *a > *b;
+}
+
+/** Fills the CNT elements of ARRAY according to PATTERN. */
+static void fill(int *array, size_t cnt, enum pattern pattern) {
+  size_t i;
+
+  for (i = 0; i < cnt; i++) {
+    switch (pattern) {
+      case RANDOM:
+        array[i] = random_ulong() % (cnt * 4);
+        break;
+      case SORTED:
+        array[i] = i;
+        break;
+      case REVERSED:
+        array[i] = cnt - i;
+        break;
+      case FEW_VALUES:
+        array[i] = random_ulong() % 8;
+        break;
+      default:
+        NOT_REACHED();
+    }
+  }
+}
+
+/** Fails unless the CNT elements of ARRAY are in order. */
+static void verify(const int *array, size_t cnt) {
+  size_t i;
+
+  for (i = 1; i < cnt; i++)
+    if (array[i - 1] > array[i]) fail("elements %zu and %zu out of order", i - 1, i);
+}
+
+void test_bench_sort(void) {
+  int *array = malloc(SORT_CNT * sizeof *array);
+  enum pattern p;
+
+  if (array == NULL) fail("out of memory");
+
+  for (p = 0; p < PATTERN_CNT; p++) {
+    int64_t qsort_ns = 0, typed_ns = 0, start;
+    char name[32];
+    int i;
+
+    for (i = 0; i < REPEAT; i++) {
+      fill(array, SORT_CNT, p);
+      start = timer_now_ns();
+      qsort(array, SORT_CNT, sizeof *array, compare_ints);
+      qsort_ns += timer_now_ns() - start;
+      verify(array, SORT_CNT);
+
+      fill(array, SORT_CNT, p);
+      start = timer_now_ns();
+      sort_ints(array, SORT_CNT);
+      typed_ns += timer_now_ns() - start;
+      verify(array, SORT_CNT);
+    }
+
+    snprintf(name, sizeof name, "sort.%s.qsort", pattern_names[p]);
+    bench_report(name, qsort_ns / REPEAT, "ns");
+    snprintf(name, sizeof name, "sort.%s.typed", pattern_names[p]);
+    bench_report(name, typed_ns / REPEAT, "ns");
+  }
+
+  free(array);
+}
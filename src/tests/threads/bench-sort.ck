@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('sort.random.qsort', 'sort.random.typed', 'sort.sorted.qsort', 'sort.sorted.typed',
+	     'sort.reversed.qsort', 'sort.reversed.typed', 'sort.few.qsort', 'sort.few.typed');
@@ -0,0 +1,66 @@
+/** Measures wakeup-to-run latency: the time from sema_up() on a
+   semaphore to the waiting thread running.  The waiter either has
+   a higher priority than the waker, so that it preempts it
+   immediately, or the same priority, so that it runs once the
+   waker blocks. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** Wakeups to time for each priority. */
+#define WAKEUP_CNT 1000
+
+struct wakeup {
+  struct semaphore go;   /**< Upped by the waker. */
+  struct semaphore done; /**< Upped by the waiter after each sample. */
+  int64_t start;         /**< When "go" was upped. */
+  int64_t *samples;      /**< WAKEUP_CNT latencies, in ns. */
+};
+
+/** Records how long each wakeup took to get it running. */
+static void waiter(void *w_) {
+  struct wakeup *w = w_;
+  int i;
+
+  for (i = 0; i < WAKEUP_CNT; i++) {
+    sema_down(&w->go);
+    w->samples[i] = timer_now_ns() - w->start;
+    sema_up(&w->done);
+  }
+}
+
+/** Times WAKEUP_CNT wakeups of a thread at PRIORITY and reports
+   them as METRIC. */
+static void measure(const char *metric, int priority) {
+  struct wakeup w;
+  int i;
+
+  sema_init(&w.go, 0);
+  sema_init(&w.done, 0);
+  w.samples = malloc(WAKEUP_CNT * sizeof *w.samples);
+  if (w.samples == NULL) fail("out of memory");
+
+  thread_create("waiter", priority, waiter, &w);
+  for (i = 0; i < WAKEUP_CNT; i++) {
+    w.start = timer_now_ns();
+    sema_up(&w.go);
+    sema_down(&w.done);
+  }
+  bench_summary(metric, w.samples, WAKEUP_CNT);
+  free(w.samples);
+}
+
+void test_bench_wakeup(void) {
+  /* This test does not work with the MLFQS. */
+  ASSERT(!thread_mlfqs());
+
+  measure("wakeup.preempt", PRI_DEFAULT + 1);
+  measure("wakeup.equal", PRI_DEFAULT);
+}
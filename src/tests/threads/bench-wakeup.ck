@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_bench ('wakeup.preempt.mean', 'wakeup.preempt.p50', 'wakeup.preempt.p90', 'wakeup.preempt.p99', 'wakeup.preempt.max',
+	     'wakeup.equal.mean', 'wakeup.equal.p50', 'wakeup.equal.p90', 'wakeup.equal.p99', 'wakeup.equal.max');
@@ -0,0 +1,90 @@
+/** Checks the word-at-a-time counting, searching, and range
+   setting functions in lib/kernel/bitmap.c against a simple
+   bit-by-bit model.  A mismatch fails an assertion. */
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+
+#include "tests/threads/tests.h"
+
+/** Maximum number of bits in a bitmap that we will test. */
+#define MAX_BITS 200
+
+static void randomize(struct bitmap *, bool *, size_t);
+static void verify_ranges(const struct bitmap *, const bool *, size_t);
+
+void test_lib_bitmap(void) {
+  size_t bit_cnt;
+
+  for (bit_cnt = 0; bit_cnt <= MAX_BITS; bit_cnt++) {
+    int repeat;
+
+    if (bit_cnt % 50 == 0) msg("testing %zu-bit bitmaps", bit_cnt);
+    for (repeat = 0; repeat < 10; repeat++) {
+      static bool model[MAX_BITS];
+      struct bitmap *b = bitmap_create(bit_cnt);
+      size_t start, cnt, i;
+      bool value;
+
+      ASSERT(b != NULL);
+      randomize(b, model, bit_cnt);
+      verify_ranges(b, model, bit_cnt);
+
+      /* Set a random range and check every bit. */
+      start = random_ulong() % (bit_cnt + 1);
+      cnt = random_ulong() % (bit_cnt - start + 1);
+      value = random_ulong() % 2;
+      bitmap_set_multiple(b, start, cnt, value);
+      for (i = start; i < start + cnt; i++) model[i] = value;
+      for (i = 0; i < bit_cnt; i++) ASSERT(bitmap_test(b, i) == model[i]);
+      verify_ranges(b, model, bit_cnt);
+
+      bitmap_destroy(b);
+    }
+  }
+}
+
+/** Sets the BIT_CNT bits in B and MODEL to the same random
+   values, with a density that varies from bitmap to bitmap so
+   that long runs of both values occur. */
+static void randomize(struct bitmap *b, bool *model, size_t bit_cnt) {
+  unsigned long density = random_ulong() % 8;
+  size_t i;
+
+  for (i = 0; i < bit_cnt; i++) {
+    model[i] = random_ulong() % 8 < density;
+    bitmap_set(b, i, model[i]);
+  }
+}
+
+/** Checks bitmap_count(), bitmap_contains(), and bitmap_scan()
+   on B against MODEL for random ranges. */
+static void verify_ranges(const struct bitmap *b, const bool *model, size_t bit_cnt) {
+  int repeat;
+
+  for (repeat = 0; repeat < 20; repeat++) {
+    size_t start = random_ulong() % (bit_cnt + 1);
+    size_t cnt = random_ulong() % (bit_cnt - start + 1);
+    bool value = random_ulong() % 2;
+    size_t value_cnt, expected, i, j;
+
+    value_cnt = 0;
+    for (i = start; i < start + cnt; i++) value_cnt += model[i] == value;
+    ASSERT(bitmap_count(b, start, cnt, value) == value_cnt);
+    ASSERT(bitmap_contains(b, start, cnt, value) == (value_cnt > 0));
+
+    /* The first run of CNT bits set to VALUE at or after START,
+       found the slow way. */
+    expected = BITMAP_ERROR;
+    for (i = start; cnt <= bit_cnt && i <= bit_cnt - cnt; i++) {
+      for (j = 0; j < cnt && model[i + j] == value; j++) continue;
+      if (j == cnt) {
+        expected = i;
+        break;
+      }
+    }
+    ASSERT(bitmap_scan(b, start, cnt, value) == expected);
+  }
+}
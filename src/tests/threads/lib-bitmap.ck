@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(lib-bitmap) begin
+(lib-bitmap) testing 0-bit bitmaps
+(lib-bitmap) testing 50-bit bitmaps
+(lib-bitmap) testing 100-bit bitmaps
+(lib-bitmap) testing 150-bit bitmaps
+(lib-bitmap) testing 200-bit bitmaps
+(lib-bitmap) end
+EOF
+pass;
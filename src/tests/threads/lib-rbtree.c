@@ -0,0 +1,176 @@
+/** Checks lib/kernel/rbtree.c.  Inserts and removes random keys,
+   checking every so often that the red-black properties hold,
+   that in-order traversal and the bound functions agree with a
+   simple array model, and that the augmented data supports
+   interval overlap queries.  A mismatch fails an assertion. */
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <rbtree.h>
+
+#include "tests/threads/tests.h"
+
+/** Maximum number of nodes in a tree that we will test. */
+#define MAX_NODES 256
+
+/** Keys are drawn from 0...KEY_RANGE, so some repeat. */
+#define KEY_RANGE 512
+
+/** An interval [KEY, END) in a tree. */
+struct value {
+  struct rb_node node; /**< Tree node. */
+  int key;             /**< Start of interval; the tree's key. */
+  int end;             /**< End of interval. */
+  int max_end;         /**< Greatest END in this subtree. */
+  bool in_tree;        /**< Currently in the tree? */
+};
+
+static int verify_node(const struct rb_node *, const struct rb_node *parent, size_t *cnt);
+static void verify_order(struct rb_tree *, struct value[], size_t cnt);
+static void verify_overlap(struct rb_tree *, struct value[]);
+static bool value_less(const struct rb_node *, const struct rb_node *, void *);
+static void value_update(struct rb_node *, void *);
+
+void test_lib_rbtree(void) {
+  static struct value values[MAX_NODES];
+  struct rb_tree tree;
+  size_t cnt = 0;
+  int op;
+
+  rb_init(&tree, value_less, value_update, NULL);
+
+  for (op = 0; op < 20000; op++) {
+    struct value *v = &values[random_ulong() % MAX_NODES];
+
+    if (!v->in_tree) {
+      v->key = random_ulong() % KEY_RANGE;
+      v->end = v->key + 1 + random_ulong() % 32;
+      rb_insert(&tree, &v->node);
+      cnt++;
+    } else {
+      rb_remove(&tree, &v->node);
+      cnt--;
+    }
+    v->in_tree = !v->in_tree;
+
+    if (op % 100 == 0) {
+      size_t seen = 0;
+
+      ASSERT(!tree.root || !tree.root->red);
+      verify_node(tree.root, NULL, &seen);
+      ASSERT(seen == cnt);
+      verify_order(&tree, values, cnt);
+      verify_overlap(&tree, values);
+    }
+    if (op % 5000 == 0) msg("%d insertions and removals", op);
+  }
+}
+
+/** Verifies the subtree rooted at N, whose parent is PARENT: no
+   red node has a red child, both sides have the same number of
+   black nodes, and the augmented data is up to date.  Adds the
+   number of nodes to *CNT and returns the subtree's black
+   height. */
+static int verify_node(const struct rb_node *n, const struct rb_node *parent, size_t *cnt) {
+  const struct value *v;
+  int left, right, max_end;
+
+  if (n == NULL) return 1;
+
+  ASSERT(n->parent == parent);
+  ASSERT(!n->red || ((n->left == NULL || !n->left->red) && (n->right == NULL || !n->right->red)));
+
+  left = verify_node(n->left, n, cnt);
+  right = verify_node(n->right, n, cnt);
+  ASSERT(left == right);
+
+  v = rb_entry(n, struct value, node);
+  max_end = v->end;
+  if (n->left != NULL && rb_entry(n->left, struct value, node)->max_end > max_end) max_end = rb_entry(n->left, struct value, node)->max_end;
+  if (n->right != NULL && rb_entry(n->right, struct value, node)->max_end > max_end) max_end = rb_entry(n->right, struct value, node)->max_end;
+  ASSERT(v->max_end == max_end);
+
+  (*cnt)++;
+  return left + !n->red;
+}
+
+/** Verifies that TREE, holding the CNT elements of VALUES whose
+   `in_tree' is set, is traversed in order both ways, and that
+   rb_find(), rb_lower_bound() and rb_upper_bound() agree with a
+   linear search. */
+static void verify_order(struct rb_tree *tree, struct value values[], size_t cnt) {
+  struct value key;
+  struct rb_node *n;
+  size_t i, seen;
+  int prev, lower, upper;
+
+  for (n = rb_first(tree), prev = -1, seen = 0; n != NULL; n = rb_next(n), seen++) {
+    ASSERT(rb_entry(n, struct value, node)->key >= prev);
+    prev = rb_entry(n, struct value, node)->key;
+  }
+  ASSERT(seen == cnt);
+
+  for (n = rb_last(tree), prev = KEY_RANGE, seen = 0; n != NULL; n = rb_prev(n), seen++) {
+    ASSERT(rb_entry(n, struct value, node)->key <= prev);
+    prev = rb_entry(n, struct value, node)->key;
+  }
+  ASSERT(seen == cnt);
+
+  /* Find the smallest key not less than, and greater than, a
+     random key. */
+  key.key = random_ulong() % (KEY_RANGE + 1);
+  lower = upper = KEY_RANGE;
+  for (i = 0; i < MAX_NODES; i++)
+    if (values[i].in_tree) {
+      if (values[i].key >= key.key && values[i].key < lower) lower = values[i].key;
+      if (values[i].key > key.key && values[i].key < upper) upper = values[i].key;
+    }
+
+  n = rb_lower_bound(tree, &key.node);
+  ASSERT(n != NULL ? rb_entry(n, struct value, node)->key == lower : lower == KEY_RANGE);
+  ASSERT(n == NULL || rb_prev(n) == NULL || rb_entry(rb_prev(n), struct value, node)->key < key.key);
+  n = rb_upper_bound(tree, &key.node);
+  ASSERT(n != NULL ? rb_entry(n, struct value, node)->key == upper : upper == KEY_RANGE);
+  n = rb_find(tree, &key.node);
+  ASSERT(n != NULL ? rb_entry(n, struct value, node)->key == key.key : lower != key.key);
+}
+
+/** Verifies that a search guided by the augmented data finds an
+   interval overlapping a random interval exactly when a linear
+   search does. */
+static void verify_overlap(struct rb_tree *tree, struct value values[]) {
+  int start = random_ulong() % KEY_RANGE;
+  int end = start + 1 + random_ulong() % 16;
+  const struct rb_node *n = tree->root;
+  bool expected = false;
+  size_t i;
+
+  for (i = 0; i < MAX_NODES; i++)
+    if (values[i].in_tree && values[i].key < end && start < values[i].end) expected = true;
+
+  while (n != NULL) {
+    const struct value *v = rb_entry(n, struct value, node);
+
+    if (v->key < end && start < v->end) break;
+    if (n->left != NULL && rb_entry(n->left, struct value, node)->max_end > start)
+      n = n->left;
+    else
+      n = n->right;
+  }
+  ASSERT((n != NULL) == expected);
+}
+
+/** Returns true if value A's key is less than value B's. */
+static bool value_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct value, node)->key < rb_entry(b, struct value, node)->key;
+}
+
+/** Recomputes the greatest interval end in N's subtree. */
+static void value_update(struct rb_node *n, void *aux UNUSED) {
+  struct value *v = rb_entry(n, struct value, node);
+
+  v->max_end = v->end;
+  if (n->left != NULL && rb_entry(n->left, struct value, node)->max_end > v->max_end) v->max_end = rb_entry(n->left, struct value, node)->max_end;
+  if (n->right != NULL && rb_entry(n->right, struct value, node)->max_end > v->max_end) v->max_end = rb_entry(n->right, struct value, node)->max_end;
+}
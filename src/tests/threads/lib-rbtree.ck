@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(lib-rbtree) begin
+(lib-rbtree) 0 insertions and removals
+(lib-rbtree) 5000 insertions and removals
+(lib-rbtree) 10000 insertions and removals
+(lib-rbtree) 15000 insertions and removals
+(lib-rbtree) end
+EOF
+pass;
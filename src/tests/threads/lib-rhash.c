@@ -0,0 +1,121 @@
+/** Checks lib/kernel/rhash.c against a simple array model, with
+   random insertions, replacements, deletions, searches and
+   iterations, on tables of various sizes and on one whose hash
+   function makes most keys collide.  A mismatch fails an
+   assertion. */
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <random.h>
+#include <rhash.h>
+
+#include "tests/threads/tests.h"
+
+/** Number of distinct keys used by the tests. */
+#define MAX_KEYS 4096
+
+/** An element of a table. */
+struct value {
+  struct rhash_elem r_elem; /**< Element in a struct rhash. */
+  int key;                  /**< Key. */
+};
+
+static struct value values[MAX_KEYS];
+
+static void check(rhash_hash_func *, int key_cnt);
+static unsigned value_rhash(const struct rhash_elem *, void *);
+static unsigned value_rhash_bad(const struct rhash_elem *, void *);
+static bool value_rless(const struct rhash_elem *, const struct rhash_elem *, void *);
+
+void test_lib_rhash(void) {
+  int key_cnt;
+  int i;
+
+  for (i = 0; i < MAX_KEYS; i++) values[i].key = i;
+
+  for (key_cnt = 1; key_cnt <= MAX_KEYS; key_cnt *= 4) {
+    msg("%d-key tables", key_cnt);
+    check(value_rhash, key_cnt);
+  }
+  msg("testing 256 colliding keys");
+  check(value_rhash_bad, 256);
+}
+
+/** Applies random insertions, replacements, deletions, and
+   searches with keys 0...KEY_CNT to a table that hashes with
+   HASH, verifying each result against a model of the table. */
+static void check(rhash_hash_func *hash, int key_cnt) {
+  static bool present[MAX_KEYS];
+  size_t cnt = 0;
+  struct rhash h;
+  int op;
+
+  ASSERT(rhash_init(&h, hash, value_rless, NULL));
+  ASSERT(rhash_initialized(&h));
+  for (op = 0; op < 50 * key_cnt; op++) {
+    int k = random_ulong() % key_cnt;
+    struct value key;
+    struct rhash_elem *e;
+
+    key.key = k;
+    switch (random_ulong() % 4) {
+      case 0:
+        e = rhash_insert(&h, &values[k].r_elem);
+        ASSERT(present[k] ? e == &values[k].r_elem : e == NULL);
+        if (!present[k]) cnt++;
+        present[k] = true;
+        break;
+
+      case 1:
+        e = rhash_replace(&h, &values[k].r_elem);
+        ASSERT(present[k] ? e == &values[k].r_elem : e == NULL);
+        if (!present[k]) cnt++;
+        present[k] = true;
+        break;
+
+      case 2:
+        e = rhash_delete(&h, &key.r_elem);
+        ASSERT(present[k] ? e == &values[k].r_elem : e == NULL);
+        if (present[k]) cnt--;
+        present[k] = false;
+        break;
+
+      case 3:
+        e = rhash_find(&h, &key.r_elem);
+        ASSERT(present[k] ? e == &values[k].r_elem : e == NULL);
+        break;
+    }
+    ASSERT(rhash_size(&h) == cnt);
+
+    /* Every so often, check that iteration sees each element
+       exactly once. */
+    if (op % 64 == 0) {
+      struct rhash_iterator i;
+      size_t seen = 0;
+
+      rhash_first(&i, &h);
+      while (rhash_next(&i)) {
+        ASSERT(present[rhash_entry(rhash_cur(&i), struct value, r_elem)->key]);
+        seen++;
+      }
+      ASSERT(seen == cnt);
+    }
+  }
+
+  rhash_destroy(&h, NULL);
+  ASSERT(!rhash_initialized(&h));
+  for (op = 0; op < key_cnt; op++) present[op] = false;
+}
+
+/** Returns a hash value for the key of E. */
+static unsigned value_rhash(const struct rhash_elem *e, void *aux UNUSED) { return hash_int(rhash_entry(e, struct value, r_elem)->key); }
+
+/** Returns a hash value for the key of E that collides with
+   those of many other keys. */
+static unsigned value_rhash_bad(const struct rhash_elem *e, void *aux UNUSED) { return rhash_entry(e, struct value, r_elem)->key % 7; }
+
+/** Returns true if the key of A is less than that of B. */
+static bool value_rless(const struct rhash_elem *a, const struct rhash_elem *b, void *aux UNUSED) {
+  return rhash_entry(a, struct value, r_elem)->key < rhash_entry(b, struct value, r_elem)->key;
+}
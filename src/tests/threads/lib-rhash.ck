@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(lib-rhash) begin
+(lib-rhash) 1-key tables
+(lib-rhash) 4-key tables
+(lib-rhash) 16-key tables
+(lib-rhash) 64-key tables
+(lib-rhash) 256-key tables
+(lib-rhash) 1024-key tables
+(lib-rhash) 4096-key tables
+(lib-rhash) testing 256 colliding keys
+(lib-rhash) end
+EOF
+pass;
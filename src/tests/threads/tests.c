@@ -37,6 +37,17 @@ static const struct test tests[] = {
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"workqueue", test_workqueue},
+    {"lib-bitmap", test_lib_bitmap},
+    {"lib-rbtree", test_lib_rbtree},
+    {"lib-rhash", test_lib_rhash},
+    {"bench-ctxsw", test_bench_ctxsw},
+    {"bench-wakeup", test_bench_wakeup},
+    {"bench-sleep", test_bench_sleep},
+    {"bench-lock-chain", test_bench_lock_chain},
+    {"bench-ready-scale", test_bench_ready_scale},
+    {"bench-sort", test_bench_sort},
+    {"bench-rhash", test_bench_rhash},
 };
 
 static const char *test_name;
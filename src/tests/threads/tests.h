@@ -33,6 +33,17 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_workqueue;
+extern test_func test_lib_bitmap;
+extern test_func test_lib_rbtree;
+extern test_func test_lib_rhash;
+extern test_func test_bench_ctxsw;
+extern test_func test_bench_wakeup;
+extern test_func test_bench_sleep;
+extern test_func test_bench_lock_chain;
+extern test_func test_bench_ready_scale;
+extern test_func test_bench_sort;
+extern test_func test_bench_rhash;
 
 void msg(const char *, ...);
 void fail(const char *, ...);
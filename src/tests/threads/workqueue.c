@@ -0,0 +1,105 @@
+/** Checks the work queues: queued items run highest priority
+   first, an item is pending at most once, delayed items wait for
+   their ticks, cancelled items do not run, bottom halves preempt
+   the thread that queues them, and work_flush() waits for an
+   item that requeues itself. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+/** A work item that records when it runs. */
+struct job {
+  struct work work; /**< The work item. */
+  const char *name; /**< Name to log. */
+  int64_t ran_at;   /**< Tick it last ran at, or -1. */
+  int run_cnt;      /**< Number of times run. */
+  int requeue_cnt;  /**< Times left to queue itself again. */
+};
+
+/** Names of jobs in the order they ran. */
+static const char *order[8];
+static int order_cnt;
+
+static work_func job_func;
+static void job_init(struct job *, const char *name, enum work_priority);
+
+void test_workqueue(void) {
+  static const char *names[] = {"low", "normal", "high"};
+  static const enum work_priority priorities[] = {WORK_LOW, WORK_NORMAL, WORK_HIGH};
+  struct job jobs[3], delayed, cancelled, bh, self;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT(!thread_mlfqs());
+
+  /* Above every worker but the bottom-half thread, so that
+     nothing queued runs until we block. */
+  thread_set_priority(PRI_MAX - 1);
+
+  for (i = 0; i < 3; i++) {
+    job_init(&jobs[i], names[i], priorities[i]);
+    work_queue(&jobs[i].work);
+  }
+  if (work_queue(&jobs[0].work)) fail("queued a pending item twice");
+  for (i = 0; i < 3; i++) work_flush(&jobs[i].work);
+  for (i = 0; i < order_cnt; i++) msg("%s ran", order[i]);
+  for (i = 0; i < 3; i++)
+    if (jobs[i].run_cnt != 1) fail("%s ran %d times", jobs[i].name, jobs[i].run_cnt);
+
+  job_init(&delayed, "delayed", WORK_NORMAL);
+  int64_t start = timer_ticks();
+  work_queue_delayed(&delayed.work, 5);
+  work_flush(&delayed.work);
+  if (delayed.ran_at - start < 5) fail("delayed item ran after %lld ticks", delayed.ran_at - start);
+  msg("delayed item waited");
+
+  job_init(&cancelled, "cancelled", WORK_NORMAL);
+  work_queue_delayed(&cancelled.work, 1000);
+  if (!work_cancel(&cancelled.work)) fail("work_cancel() failed");
+  if (work_pending(&cancelled.work) || work_cancel(&cancelled.work)) fail("cancelled item still pending");
+  work_flush(&cancelled.work);
+  if (cancelled.run_cnt != 0) fail("cancelled item ran");
+  msg("cancelled item did not run");
+
+  job_init(&bh, "bottom half", WORK_BH);
+  work_queue(&bh.work);
+  if (bh.run_cnt != 1) fail("bottom half did not preempt");
+  msg("bottom half ran before work_queue() returned");
+
+  job_init(&self, "self", WORK_LOW);
+  self.requeue_cnt = 3;
+  work_queue(&self.work);
+  work_flush(&self.work);
+  msg("requeued item ran %d times", self.run_cnt);
+}
+
+/** Initializes JOB, named NAME, to run at PRIORITY. */
+static void job_init(struct job *job, const char *name, enum work_priority priority) {
+  work_init(&job->work, job_func, priority);
+  job->name = name;
+  job->ran_at = -1;
+  job->run_cnt = 0;
+  job->requeue_cnt = 0;
+}
+
+/** Records that W's job ran, and queues it again if it has
+   requeues left. */
+static void job_func(struct work *w) {
+  struct job *job = container_of(w, struct job, work);
+  enum intr_level old_level = intr_disable();
+
+  if (order_cnt < (int)(sizeof order / sizeof *order)) order[order_cnt++] = job->name;
+  intr_set_level(old_level);
+
+  job->ran_at = timer_ticks();
+  job->run_cnt++;
+  if (job->requeue_cnt > 0) {
+    job->requeue_cnt--;
+    work_queue(w);
+  }
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) high ran
+(workqueue) normal ran
+(workqueue) low ran
+(workqueue) delayed item waited
+(workqueue) cancelled item did not run
+(workqueue) bottom half ran before work_queue() returned
+(workqueue) requeued item ran 4 times
+(workqueue) end
+EOF
+pass;
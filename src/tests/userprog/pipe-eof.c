@@ -0,0 +1,26 @@
+/** Reads from a pipe whose write end is closed, which gives end
+   of file once the data is used up, and writes to a pipe whose
+   read end is closed, which fails. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  char buf[16];
+  int fds[2];
+
+  CHECK(pipe(fds), "pipe");
+  CHECK(write(fds[1], "abc", 3) == 3, "write to pipe");
+  close(fds[1]);
+  CHECK(read(fds[0], buf, sizeof buf) == 3, "read 3 bytes");
+  CHECK(read(fds[0], buf, sizeof buf) == 0, "read end of file");
+  close(fds[0]);
+
+  CHECK(pipe(fds), "pipe");
+  close(fds[0]);
+  CHECK(write(fds[1], "abc", 3) == -1, "write with no reader");
+  CHECK(read(fds[1], buf, sizeof buf) == -1, "read from write end");
+  close(fds[1]);
+}
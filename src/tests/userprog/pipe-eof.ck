@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-eof) begin
+(pipe-eof) pipe
+(pipe-eof) write to pipe
+(pipe-eof) read 3 bytes
+(pipe-eof) read end of file
+(pipe-eof) pipe
+(pipe-eof) write with no reader
+(pipe-eof) read from write end
+(pipe-eof) end
+pipe-eof: exit(0)
+EOF
+pass;
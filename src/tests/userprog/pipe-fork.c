@@ -0,0 +1,61 @@
+/** Forks a child that writes 32 kB into a pipe in odd-sized
+   pieces and exits.  The parent then reads it all into a
+   page-aligned buffer, whose pages are resident and its own, so
+   that every full page in the pipe is handed over rather than
+   copied.  The parent must see exactly what the child wrote, and
+   then end of file.  It then prints the thread statistics, in
+   which pipe-fork.ck checks that pages were handed over. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/** As much as the pipe holds, so that the child does not wait
+   for the parent to read. */
+#define SIZE (32 * 1024)
+#define CHUNK 5000
+
+static char src[SIZE];
+static char dst[SIZE] __attribute__((aligned(4096)));
+
+void test_main(void) {
+  size_t ofs;
+  pid_t child;
+  int fds[2];
+  int n;
+
+  random_bytes(src, sizeof src);
+  CHECK(pipe(fds), "pipe");
+  msg("fork");
+  child = fork();
+  if (child == PID_ERROR) fail("fork failed");
+  if (child == 0) {
+    close(fds[0]);
+    for (ofs = 0; ofs < SIZE; ofs += CHUNK) {
+      int chunk = SIZE - ofs < CHUNK ? SIZE - ofs : CHUNK;
+      if (write(fds[1], src + ofs, chunk) != chunk) fail("write at %zu failed", ofs);
+    }
+    exit(0x42);
+  }
+
+  /* Waiting first leaves every page in the pipe full, and keeps
+     the output in a fixed order. */
+  close(fds[1]);
+  msg("wait for child: %d", wait(child));
+
+  /* Under VM, a page of DST that has never been touched is not
+     resident, and only a resident page can be handed over. */
+  memset(dst, 0, sizeof dst);
+  for (ofs = 0; ofs < SIZE; ofs += n) {
+    n = read(fds[0], dst + ofs, SIZE - ofs);
+    if (n <= 0) fail("read at %zu returned %d", ofs, n);
+  }
+  n = read(fds[0], dst, 1);
+  if (n != 0) fail("read past end returned %d", n);
+  if (memcmp(src, dst, SIZE)) fail("read data differs from written data");
+  close(fds[0]);
+  threadstats();
+}
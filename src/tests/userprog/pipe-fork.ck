@@ -0,0 +1,34 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# The statistics table must show that the test process received
+# pages from the pipe by remapping rather than copying.
+my ($header) = grep (/^\s*tid\s+name\s+status\s/, @output);
+fail "missing statistics table header\n" if !defined $header;
+my (@columns) = split (' ', $header);
+my ($flips) = grep ($columns[$_] eq 'flips', 0...$#columns);
+fail "missing flips column\n" if !defined $flips;
+
+my (@table) = grep (/^\s*\d+\s+\S+\s+(running|ready|blocked|dying)\s/, @output);
+my ($row) = grep ((split)[1] eq 'pipe-fork' && (split)[2] eq 'running', @table);
+fail "no row for test process\n" if !defined $row;
+fail "no pages were handed over\n" if (split (' ', $row))[$flips] == 0;
+
+@output = grep ($_ ne $header && !/^\s*\d+\s+\S+\s+(running|ready|blocked|dying)\s/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(pipe-fork) begin
+(pipe-fork) pipe
+(pipe-fork) fork
+pipe-fork: exit(66)
+(pipe-fork) wait for child: 66
+(pipe-fork) end
+pipe-fork: exit(0)
+EOF
+pass;
@@ -0,0 +1,21 @@
+/** Writes to a pipe and reads the data back in the same
+   process. */
+
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  static const char sample[] = "Amazing Electronic Fact: ...";
+  char buf[sizeof sample];
+  int fds[2];
+
+  CHECK(pipe(fds), "pipe");
+  CHECK(write(fds[1], sample, sizeof sample) == (int)sizeof sample, "write to pipe");
+  CHECK(read(fds[0], buf, sizeof buf) == (int)sizeof buf, "read from pipe");
+  if (memcmp(buf, sample, sizeof sample)) fail("read data differs from written data");
+  close(fds[0]);
+  close(fds[1]);
+}
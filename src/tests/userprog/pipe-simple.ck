@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-simple) begin
+(pipe-simple) pipe
+(pipe-simple) write to pipe
+(pipe-simple) read from pipe
+(pipe-simple) end
+pipe-simple: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+/** Writes and reads a file at explicit positions with pwrite()
+   and pread(), which must not move the file's own position. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  char buf[8];
+  int fd;
+
+  CHECK(create("data", 64), "create \"data\"");
+  CHECK((fd = open("data")) > 1, "open \"data\"");
+  CHECK(pwrite(fd, "world", 5, 40) == 5, "pwrite 5 bytes at 40");
+  CHECK(pwrite(fd, "hello", 5, 10) == 5, "pwrite 5 bytes at 10");
+  CHECK(tell(fd) == 0, "position is still 0");
+  CHECK(pread(fd, buf, 5, 40) == 5 && !memcmp(buf, "world", 5), "pread 5 bytes at 40");
+  CHECK(pread(fd, buf, 5, 10) == 5 && !memcmp(buf, "hello", 5), "pread 5 bytes at 10");
+  CHECK(pread(fd, buf, 8, 60) == 4, "pread at end of file is short");
+  CHECK(pread(STDIN_FILENO, buf, 1, 0) == -1, "pread from console fails");
+  close(fd);
+}
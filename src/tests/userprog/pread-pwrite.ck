@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "data"
+(pread-pwrite) open "data"
+(pread-pwrite) pwrite 5 bytes at 40
+(pread-pwrite) pwrite 5 bytes at 10
+(pread-pwrite) position is still 0
+(pread-pwrite) pread 5 bytes at 40
+(pread-pwrite) pread 5 bytes at 10
+(pread-pwrite) pread at end of file is short
+(pread-pwrite) pread from console fails
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+/** Writes a file from three buffers with writev() and reads it
+   back into two with readv(). */
+
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  char a[] = "Amazing ", b[] = "Electronic ", c[] = "Fact";
+  struct iovec out[] = {{a, 8}, {b, 11}, {c, 4}};
+  char x[10], y[13];
+  struct iovec in[] = {{x, sizeof x}, {y, sizeof y}};
+  int fd;
+
+  CHECK(create("data", 23), "create \"data\"");
+  CHECK((fd = open("data")) > 1, "open \"data\"");
+  CHECK(writev(fd, out, 3) == 23, "writev 23 bytes");
+  seek(fd, 0);
+  CHECK(readv(fd, in, 2) == 23, "readv 23 bytes");
+  if (memcmp(x, "Amazing El", 10) || memcmp(y, "ectronic Fact", 13)) fail("read data differs from written data");
+  CHECK(readv(fd, in, IOV_MAX + 1) == -1, "readv with too many iovecs fails");
+  close(fd);
+}
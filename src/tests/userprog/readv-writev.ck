@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "data"
+(readv-writev) open "data"
+(readv-writev) writev 23 bytes
+(readv-writev) readv 23 bytes
+(readv-writev) readv with too many iovecs fails
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
@@ -0,0 +1,9 @@
+/** Prints the per-thread statistics table and checks, in
+   threadstats.ck, that it lists this process as running. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) { threadstats(); }
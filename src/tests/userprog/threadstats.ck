@@ -0,0 +1,28 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+my ($header) = grep (/^\s*tid\s+name\s+status\s/, @output);
+fail "missing statistics table header\n" if !defined $header;
+my (@columns) = split (' ', $header);
+
+my (%rows);
+foreach (@output) {
+    my (@fields) = split;
+    next if @fields != @columns || $fields[0] !~ /^\d+$/;
+    fail "malformed statistics row: $_\n"
+      if grep (!/^-?\d+$/, @fields[3...$#fields]);
+    $rows{$fields[1]} = \@fields;
+}
+
+fail "no row for idle thread\n" if !defined $rows{'idle'};
+fail "no row for test process\n" if !defined $rows{'threadstats'};
+fail "test process not shown as running\n"
+  if $rows{'threadstats'}[2] ne 'running';
+pass;
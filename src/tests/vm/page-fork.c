@@ -0,0 +1,51 @@
+/** Forks with a 64 kB buffer in the data segment.  The child
+   must see the parent's contents and its writes must not show
+   up in the parent, and vice versa. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char buf[SIZE];
+
+/** Returns true if every byte of BUF is I * 257 + SEED. */
+static bool check(int seed) {
+  size_t i;
+
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != (char)(i * 257 + seed)) return false;
+  return true;
+}
+
+static void fill(int seed) {
+  size_t i;
+
+  for (i = 0; i < sizeof buf; i++) buf[i] = i * 257 + seed;
+}
+
+void test_main(void) {
+  pid_t child;
+  int status;
+
+  fill(0);
+  msg("fork");
+  child = fork();
+  if (child == PID_ERROR) fail("fork failed");
+  if (child == 0) {
+    if (!check(0)) fail("child sees wrong data");
+    fill(1);
+    if (!check(1)) fail("child's writes were lost");
+    exit(0x42);
+  }
+
+  /* Write to the pages while the child may still share them.
+     Print nothing until the child has exited, so that the output
+     is in a fixed order. */
+  fill(2);
+  status = wait(child);
+  msg("wait for child: %d", status);
+  if (!check(2)) fail("child's writes showed up in parent");
+}
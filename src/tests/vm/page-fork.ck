@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(page-fork) begin
+(page-fork) fork
+page-fork: exit(66)
+(page-fork) wait for child: 66
+(page-fork) end
+page-fork: exit(0)
+EOF
+pass;
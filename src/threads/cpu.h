@@ -0,0 +1,52 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdint.h>
+
+#include "threads/flags.h"
+
+/** Returns the processor's time-stamp counter, which counts
+   clock cycles since reset.  Requires a Pentium or later. */
+static inline uint64_t rdtsc(void) {
+  /* See [IA32-v2b] "RDTSC". */
+  uint64_t tsc;
+  asm volatile("rdtsc" : "=A"(tsc));
+  return tsc;
+}
+
+/** Feature flags reported in EDX by CPUID leaf 1.  See
+   [IA32-v2a] "CPUID". */
+#define CPUID_PSE 0x00000008 /**< Page Size Extension: 4 MB pages. */
+#define CPUID_PGE 0x00002000 /**< Page Global Enable. */
+
+/** Returns the feature flags that CPUID leaf 1 reports in EDX, or
+   0 on a processor too old to have CPUID. */
+static inline uint32_t cpuid_features(void) {
+  uint32_t flags, old_flags, eax, ebx, ecx, edx;
+
+  /* The processor has CPUID if the ID flag in EFLAGS can be
+     changed. */
+  asm volatile(
+      "pushfl; popl %0; movl %0, %1; xorl %2, %0; pushl %0; popfl;"
+      "pushfl; popl %0; pushl %1; popfl"
+      : "=&r"(flags), "=&r"(old_flags)
+      : "i"(FLAG_ID)
+      : "cc");
+  if (((flags ^ old_flags) & FLAG_ID) == 0) return 0;
+
+  asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+  return edx;
+}
+
+/** CR4 bits.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR4_PSE 0x00000010 /**< Page Size Extensions: 4 MB pages. */
+#define CR4_PGE 0x00000080 /**< Page Global Enable. */
+
+/** Turns on the bits in BITS in control register CR4. */
+static inline void cr4_set(uint32_t bits) {
+  uint32_t cr4;
+  asm volatile("movl %%cr4, %0" : "=r"(cr4));
+  asm volatile("movl %0, %%cr4" : : "r"(cr4 | bits) : "memory");
+}
+
+#endif /**< threads/cpu.h */
@@ -5,6 +5,7 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <random.h>
+#include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -18,6 +19,7 @@
 #include "devices/shutdown.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -25,9 +27,13 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/vaddr.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
+#include "userprog/pagedir.h"
 #include "userprog/process.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
@@ -40,6 +46,11 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#endif
 
 /** Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -120,8 +131,14 @@ int pintos_init(void) {
 
   /* Start thread scheduler and enable interrupts. */
   thread_start();
+  workqueue_init();
   serial_init_queue();
+  console_init_async();
   timer_calibrate();
+  trace_init();
+#ifdef USERPROG
+  pagedir_init();
+#endif
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -130,6 +147,12 @@ int pintos_init(void) {
   filesys_init(format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  swap_init();
+  frame_init();
+#endif
+
   printf("Boot complete.\n");
 
   if (*argv != NULL) {
@@ -204,10 +227,20 @@ static void bss_init(void) {
 /** Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the processor supports global pages, the kernel mapping is
+   made global, so that its TLB entries survive the CR3 reload on
+   every switch between processes.  If it supports 4 MB pages,
+   every 4 MB of RAM that holds no kernel text is mapped with a
+   single PDE, which needs no page table and only one TLB
+   entry. */
 static void paging_init(void) {
   extern char _start, _end_kernel_text;  // defined in kernel.lds.S
 
+  uint32_t features = cpuid_features();
+  uint32_t global = features & CPUID_PGE ? PTE_G : 0;
+  bool large = (features & CPUID_PSE) != 0;
   uint32_t *pd = init_page_dir /*global*/ = palloc_get_page(PAL_ASSERT | PAL_ZERO);
   uint32_t *pt = NULL;
   for (size_t page = 0; page < init_ram_pages; page++) {  // 物理内存挂在页表下
@@ -217,20 +250,36 @@ static void paging_init(void) {
     size_t pte_idx = pt_no(vaddr);
     bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;  // if it is in .text
 
+    /* Kernel text must stay read-only, so a large page may not
+       cover any of it. */
+    if (large && pte_idx == 0 && init_ram_pages - page >= PTSPAN / PGSIZE && (vaddr + PTSPAN <= &_start || vaddr >= &_end_kernel_text)) {
+      pd[pde_idx] = pde_create_large(vaddr, true) | global;
+      page += PTSPAN / PGSIZE - 1;
+      continue;
+    }
+
     if (pd[pde_idx] == 0) {
       pt = palloc_get_page(PAL_ASSERT | PAL_ZERO);
       pd[pde_idx] = pde_create(pt);
     }
 
-    pt[pte_idx] = pte_create_kernel(vaddr, !in_kernel_text);
+    pt[pte_idx] = pte_create_kernel(vaddr, !in_kernel_text) | global;
   }
 
+  /* The large PDEs are only understood with CR4.PSE set. */
+  if (large) cr4_set(CR4_PSE);
+
   /* Store the physical address of the page directory into CR3
      aka PDBR (page directory base register).  This activates our
      new page tables immediately.  See [IA32-v2a] "MOV--Move
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile("movl %0, %%cr3" : : "r"(vtop(init_page_dir)));
+
+  /* The kernel mapping never changes after this, so its global
+     entries never need to be invalidated.  See [IA32-v3a] 3.12
+     "Translation Lookaside Buffers (TLBs)". */
+  if (global) cr4_set(CR4_PGE);
 }
 
 /* ---------- ---------- ---------- ---------- command line ---------- ---------- ---------- ---------- */
@@ -291,9 +340,17 @@ static char **parse_options(char **argv) {
     } else if (!strcmp(name, "-scratch")) {
       scratch_bdev_name = value;
     }
+#ifdef TRACE
+    else if (!strcmp(name, "-trace")) {
+      trace_dump_at_exit = true;
+    }
+#endif
 #ifdef VM
     else if (!strcmp(name, "-swap")) {
       swap_bdev_name = value;
+    } else if (!strcmp(name, "-stack")) {
+      stack_limit = ROUND_UP((size_t)atoi(value) * 1024, PGSIZE);
+      if (stack_limit < PGSIZE || stack_limit > (size_t)PHYS_BASE / 2) PANIC("-stack=%s: stack limit out of range", value);
     }
 #endif
 #endif
@@ -354,6 +411,11 @@ static int act_whoami(char **argv UNUSED) {
 
 NO_RETURN static int act_exit(char **argv UNUSED) { shutdown_power_off(); }
 
+static int act_threadstats(char **argv UNUSED) {
+  thread_print_table();
+  return 0;
+}
+
 /* An action. */
 struct action {
   const char *name;             /**< Action name. */
@@ -363,9 +425,10 @@ struct action {
 
 /* Table of supported actions. */
 static const struct action actions[] = {
-    {"run", 2, run_task},      /*  */
-    {"whoami", 1, act_whoami}, /*  */
-    {"exit", 1, act_exit},     /*  */
+    {"run", 2, run_task},                /*  */
+    {"whoami", 1, act_whoami},           /*  */
+    {"exit", 1, act_exit},               /*  */
+    {"threadstats", 1, act_threadstats}, /*  */
 #ifdef FILESYS
     {"ls", 1, fsutil_ls},           /*  */
     {"cat", 2, fsutil_cat},         /*  */
@@ -451,6 +514,7 @@ static void usage(void) {
 #else
       "  run TEST           Run TEST.\n"
 #endif
+      "  threadstats        Print CPU accounting for each thread.\n"
 #ifdef FILESYS
       "  ls                 List files in the root directory.\n"
       "  cat FILE           Print FILE to the console.\n"
@@ -467,8 +531,12 @@ static void usage(void) {
       "  -f                 Format file system device during startup.\n"
       "  -filesys=BDEV      Use BDEV for file system instead of default.\n"
       "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
+#ifdef TRACE
+      "  -trace             Dump the event trace to scratch at power off.\n"
+#endif
 #ifdef VM
       "  -swap=BDEV         Use BDEV for swap instead of default.\n"
+      "  -stack=KB          Limit user stacks to KB kB (default 8192).\n"
 #endif
 #endif
       "  -rs=SEED           Set random number seed to SEED.\n"
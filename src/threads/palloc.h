@@ -15,6 +15,8 @@ void *palloc_get_page(enum palloc_flags);
 void *palloc_get_multiple(enum palloc_flags, size_t page_cnt);
 void palloc_free_page(void *);
 void palloc_free_multiple(void *, size_t page_cnt);
+size_t palloc_user_page_cnt(void);
+size_t palloc_user_page_idx(const void *);
 
 __attribute__((weak)) size_t kernel_pages;
 
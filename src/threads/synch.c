@@ -35,6 +35,7 @@
 #include "stddef.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 
 /* ---------- ---------- semaphore ---------- ----------  */
 
@@ -291,6 +292,9 @@ void lock_acquire(struct lock *lock) {
   ASSERT(!intr_context());
   ASSERT(!lock_held_by_current_thread(lock));
 
+  bool contended = lock->holder != NULL;
+  if (contended) TRACE_EVENT(LOCK_WAIT, lock);
+
   if (!thread_mlfqs()) {  //////////////////////////////////////////////////// NOTE: priority donation
     struct thread *cur = thread_current();
     struct thread *holder = lock->holder;
@@ -303,8 +307,11 @@ void lock_acquire(struct lock *lock) {
     }
   }
 
+  enum thread_wait old_wait = thread_set_wait(WAIT_LOCK);
   sema_down(&lock->semaphore);  // ---------- 进入临界区 ----------
+  thread_set_wait(old_wait);
   lock->holder = thread_current();
+  if (contended) TRACE_EVENT(LOCK_ACQUIRE, lock);
 
   if (!thread_mlfqs()) {  //////////////////////////////////////////////////// NOTE: priority donation
     struct thread *cur = thread_current();
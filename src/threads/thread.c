@@ -16,10 +16,14 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
+#ifdef VM
+#include "vm/mmap.h"
+#endif
 
 /** Random value for struct thread's `magic' member.
    Used to detect stack overflow.  See the big comment at the top
@@ -68,6 +72,7 @@ static void init_thread(struct thread *, const char *name, int priority);
 static bool is_thread(struct thread *) UNUSED;
 static void *alloc_frame(struct thread *, size_t size);
 static void schedule(void);
+static void account(struct thread *, int64_t now);
 void thread_schedule_tail(struct thread *prev);
 static tid_t allocate_tid(void);
 static bool ready_list_less_func(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
@@ -147,6 +152,88 @@ void thread_tick(void) {
 /** Prints thread statistics. */
 void thread_print_stats(void) { printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks, kernel_ticks, user_ticks); }
 
+/** A thread's row in thread_print_table(). */
+struct thread_row {
+  tid_t tid;                 /**< Thread identifier. */
+  char name[16];             /**< Name. */
+  enum thread_status status; /**< Thread state. */
+  int priority;              /**< Priority. */
+  struct thread_stats stats; /**< Accounting, brought up to date. */
+};
+
+/** Rows that thread_print_table() copies per pass. */
+#define TABLE_BATCH 8
+
+static int snapshot_rows(struct thread_row rows[], tid_t after);
+
+/** Prints the CPU accounting of every thread, one per line under
+   a header line, in whitespace-separated columns.  Times are in
+   microseconds and include the current state up to now.
+
+   Printing with synchronous console output can take long enough
+   to lose timer ticks, so the rows are copied a few at a time
+   with interrupts off and printed with interrupts on. */
+void thread_print_table(void) {
+  static const char *status_name[] = {"running", "ready", "blocked", "dying"};
+  struct thread_row rows[TABLE_BATCH];
+  tid_t after = 0;
+  int cnt, i;
+
+  printf("%5s %-15s %-7s %3s %12s %12s %12s %12s %12s %12s %8s %8s %8s %8s\n", "tid", "name", "status", "pri", "run_us", "ready_us", "lock_us",
+         "sema_us", "io_us", "sleep_us", "vcsw", "ivcsw", "faults", "flips");
+  do {
+    cnt = snapshot_rows(rows, after);
+    for (i = 0; i < cnt; i++) {
+      const struct thread_row *r = &rows[i];
+      const struct thread_stats *s = &r->stats;
+
+      printf("%5d %-15s %-7s %3d %12lld %12lld %12lld %12lld %12lld %12lld %8u %8u %8u %8u\n", r->tid, r->name, status_name[r->status], r->priority,
+             s->run_ns / 1000, s->ready_ns / 1000, s->wait_ns[WAIT_LOCK] / 1000, s->wait_ns[WAIT_SEMA] / 1000, s->wait_ns[WAIT_IO] / 1000,
+             s->wait_ns[WAIT_SLEEP] / 1000, s->vol_switches, s->invol_switches, s->page_faults, s->page_flips);
+      after = r->tid;
+    }
+  } while (cnt == TABLE_BATCH);
+}
+
+/** Copies into ROWS, in ascending order of tid, the rows of up to
+   TABLE_BATCH threads with the smallest tids greater than AFTER,
+   and returns the number copied.  `all_list' is not in tid order,
+   since a thread joins it before it gets its tid. */
+static int snapshot_rows(struct thread_row rows[], tid_t after) {
+  enum intr_level old_level = intr_disable();
+  int64_t now = timer_now_ns();
+  struct list_elem *e;
+  int cnt = 0;
+
+  for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+    struct thread *t = container_of(e, struct thread, allelem);
+    struct thread_row *r;
+    int i;
+
+    if (t->tid <= after || (cnt == TABLE_BATCH && t->tid > rows[cnt - 1].tid)) continue;
+
+    /* Insert in tid order, dropping the largest if full. */
+    if (cnt < TABLE_BATCH) cnt++;
+    for (i = cnt - 1; i > 0 && rows[i - 1].tid > t->tid; i--) rows[i] = rows[i - 1];
+    r = &rows[i];
+
+    r->tid = t->tid;
+    strlcpy(r->name, t->name, sizeof r->name);
+    r->status = t->status;
+    r->priority = t->priority;
+    r->stats = t->stats;
+    if (t->status == THREAD_RUNNING)
+      r->stats.run_ns += now - r->stats.since;
+    else if (t->status == THREAD_READY)
+      r->stats.ready_ns += now - r->stats.since;
+    else if (t->status == THREAD_BLOCKED)
+      r->stats.wait_ns[t->wait] += now - r->stats.since;
+  }
+  intr_set_level(old_level);
+
+  return cnt;
+}
+
 /** Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -183,6 +270,7 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
   //////////////////////////////////////////////////////////////////////// }
 
   tid_t tid = t->tid = allocate_tid();
+  trace_thread_name(tid, t->name);
 
   /* Stack frame for kernel_thread(). */
   struct kernel_thread_frame *kf = alloc_frame(t, sizeof *kf);  // 从 kernel page 上划分出一块 frame (高地址)
@@ -222,6 +310,7 @@ void thread_block(void) {
   ASSERT(!intr_context());
   ASSERT(intr_get_level() == INTR_OFF);
 
+  TRACE_EVENT(BLOCK, 0);
   thread_current()->status = THREAD_BLOCKED;
   schedule();
 }
@@ -260,11 +349,24 @@ void thread_unblock(struct thread *t) {
 
   old_level = intr_disable();
   ASSERT(t->status == THREAD_BLOCKED);
+  TRACE_EVENT(UNBLOCK, t->tid);
+  account(t, timer_now_ns());
   list_push_back(&ready_list, &t->elem);
   t->status = THREAD_READY;
   intr_set_level(old_level);
 }
 
+/** Sets what the running thread's blocking is counted as waiting
+   for in its statistics, and returns the previous setting, for
+   the caller to restore. */
+enum thread_wait thread_set_wait(enum thread_wait wait) {
+  struct thread *cur = thread_current();
+  enum thread_wait old = cur->wait;
+
+  cur->wait = wait;
+  return old;
+}
+
 /** Returns the name of the running thread. */
 const char *thread_name(void) { return thread_current()->name; }
 
@@ -511,6 +613,7 @@ static void init_thread(struct thread *t, const char *name, int priority) {
   t->magic = THREAD_MAGIC;
 
   t->last_sched = last_sched();
+  t->stats.since = timer_now_ns();
 
   ////////////////////////////////////////////////////////// NOTE: init: priority donation related data structure {
   t->priority = priority;
@@ -518,8 +621,11 @@ static void init_thread(struct thread *t, const char *name, int priority) {
   list_init(&t->locks);
   //////////////////////////////////////////////////////////////////////// }
 
-#if USERPROG
-  // t->pagedir = ;
+#ifdef USERPROG
+  list_init(&t->children);
+#endif
+#ifdef VM
+  mmap_table_init(t);
 #endif
 
   old_level = intr_disable();              // get previous interrupt level
@@ -604,6 +710,8 @@ void thread_schedule_tail(struct thread *prev) {
   /* Start new time slice. */
   thread_ticks = 0;
 
+  if (prev != NULL) TRACE_EVENT(SWITCH, prev->tid);
+
 #ifdef USERPROG
   /* Activate the new address space. */
   process_activate();
@@ -635,6 +743,17 @@ static void schedule(void) {
   ASSERT(cur->status != THREAD_RUNNING);
   ASSERT(is_thread(next));
 
+  if (cur != next) {
+    int64_t now = timer_now_ns();
+
+    if (cur->status == THREAD_READY)
+      cur->stats.invol_switches++;
+    else if (cur->status == THREAD_BLOCKED)
+      cur->stats.vol_switches++;
+    account(cur, now);
+    account(next, now);
+  }
+
   // 1. push next
   // 2. push cur
   // 3. push return address
@@ -645,6 +764,21 @@ static void schedule(void) {
   thread_schedule_tail(prev);
 }
 
+/** Charges the time from when T entered its current state until
+   NOW to that state, as T leaves it.  The running thread counts
+   as running even once schedule() has changed its status. */
+static void account(struct thread *t, int64_t now) {
+  int64_t elapsed = now - t->stats.since;
+
+  if (t == running_thread())
+    t->stats.run_ns += elapsed;
+  else if (t->status == THREAD_READY)
+    t->stats.ready_ns += elapsed;
+  else if (t->status == THREAD_BLOCKED)
+    t->stats.wait_ns[t->wait] += elapsed;
+  t->stats.since = now;
+}
+
 /** Returns a tid to use for a new thread. */
 static tid_t allocate_tid(void) {
   static tid_t next_tid = 1;
@@ -4,6 +4,8 @@
 #include <debug.h>
 #include <fixed1714.h>
 #include <list.h>
+#include <rbtree.h>
+#include <rhash.h>
 #include <stdint.h>
 
 #include "kernel/list.h"
@@ -16,6 +18,29 @@ enum thread_status {
   THREAD_DYING    /**< About to be destroyed. */
 };
 
+/** What a blocked thread is waiting for, as far as its statistics
+   are concerned. */
+enum thread_wait {
+  WAIT_SEMA,  /**< A semaphore or anything else. */
+  WAIT_LOCK,  /**< A lock. */
+  WAIT_IO,    /**< A device. */
+  WAIT_SLEEP, /**< A timer. */
+  WAIT_CNT    /**< Number of reasons. */
+};
+
+/** Per-thread CPU accounting.  Times are in nanoseconds, as
+   measured by timer_now_ns(). */
+struct thread_stats {
+  int64_t since;             /**< When the thread entered its current state. */
+  int64_t run_ns;            /**< Time spent running. */
+  int64_t ready_ns;          /**< Time spent in the ready queue. */
+  int64_t wait_ns[WAIT_CNT]; /**< Time spent blocked, by reason. */
+  unsigned vol_switches;     /**< Switches away because it blocked. */
+  unsigned invol_switches;   /**< Switches away while still ready to run. */
+  unsigned page_faults;      /**< Page faults. */
+  unsigned page_flips;       /**< Pages received from pipes by remapping. */
+};
+
 /** Thread identifier type.
    You can redefine this to whatever type you like. */
 typedef int tid_t;
@@ -100,11 +125,36 @@ struct thread {
 
 #ifdef USERPROG
   /* Owned by userprog/process.c. */
-  uint32_t *pagedir; /**< Page directory. */
+  uint32_t *pagedir;          /**< Page directory. */
+  struct file *exec_file;     /**< Executable, kept open while it is mapped. */
+  struct fd_entry *files;     /**< Open files and pipes indexed by fd, or NULL. */
+  struct child_status *child; /**< Exit status shared with the parent, or NULL. */
+  struct list children;       /**< struct child_status of each child. */
+
+  /* Owned by userprog/syscall.c. */
+  struct intr_frame *syscall_frame; /**< User context in a system call, or NULL. */
+
+  /* Owned by userprog/pagedir.c. */
+  int tlb_batch;                /**< Depth of pagedir_batch_begin() calls. */
+  uintptr_t tlb_start, tlb_end; /**< Pages whose TLB entries the batch must invalidate. */
+#endif
+
+#ifdef VM
+  /* Owned by vm/page.c. */
+  struct rhash pages; /**< Supplemental page table. */
+
+  /* Owned by vm/mmap.c. */
+  struct rb_tree mappings; /**< Memory mapped files, by address. */
+  struct rb_tree mapids;   /**< The same mappings, by identifier. */
+  int next_mapid;          /**< Identifier for the next mapping. */
+  uintptr_t image_start;   /**< Start of the executable's pages. */
+  uintptr_t image_end;     /**< End of the executable's pages. */
 #endif
 
   /* Owned by thread.c. */
-  unsigned magic; /**< Detects stack overflow. */
+  enum thread_wait wait;      /**< What the thread blocks, or is blocked, waiting for. */
+  struct thread_stats stats;  /**< CPU accounting. */
+  unsigned magic;             /**< Detects stack overflow. */
 
   int64_t last_sched; /**< last schedule time. */
 
@@ -128,12 +178,14 @@ void thread_start(void);
 
 void thread_tick(void);
 void thread_print_stats(void);
+void thread_print_table(void);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
 
 void thread_block(void);
 void thread_unblock(struct thread *);
+enum thread_wait thread_set_wait(enum thread_wait);
 
 struct thread *thread_current(void);
 tid_t thread_tid(void);
@@ -0,0 +1,187 @@
+#include "threads/trace.h"
+
+#ifdef TRACE
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/block.h"
+#endif
+
+/** Pages in the event ring. */
+#define TRACE_PAGES 16
+
+/** Number of events in the ring.  A power of 2. */
+#define TRACE_CNT (TRACE_PAGES * PGSIZE / sizeof(struct trace_event))
+
+/** Number of thread names remembered, by tid modulo this.  A
+   power of 2. */
+#define NAME_CNT 256
+
+/** Identifies a trace dump.  "PTRC" in little-endian order. */
+#define TRACE_MAGIC 0x43525450
+
+/** Version of the dump format. */
+#define TRACE_VERSION 1
+
+/** A traced event. */
+struct trace_event {
+  uint64_t tsc;  /**< Time-stamp counter. */
+  uint16_t type; /**< A TRACE_* value. */
+  uint16_t tid;  /**< Running thread. */
+  uint32_t arg;  /**< Depends on TYPE. */
+};
+
+/** A thread's name, for the timeline's labels. */
+struct trace_name {
+  int32_t tid;   /**< Thread, or 0 if unused. */
+  char name[16]; /**< Its name, null-padded. */
+};
+
+/** The first sector of a dump.  It is followed by NAME_CNT struct
+   trace_name's and then EVENT_CNT events, oldest first, each
+   group starting on a new sector. */
+struct trace_header {
+  uint32_t magic;      /**< TRACE_MAGIC. */
+  uint32_t version;    /**< TRACE_VERSION. */
+  uint32_t event_size; /**< sizeof (struct trace_event). */
+  uint32_t event_cnt;  /**< Events in the dump. */
+  uint32_t lost_cnt;   /**< Older events that were overwritten. */
+  uint32_t name_cnt;   /**< NAME_CNT. */
+  uint64_t tsc_hz;     /**< Time-stamp counter frequency, in Hz. */
+};
+
+/** Dump the ring to the scratch device at shutdown? */
+bool trace_dump_at_exit;
+
+static struct trace_event *events; /**< Event ring. */
+static uint32_t event_head;        /**< Events recorded so far. */
+static struct trace_name names[NAME_CNT];
+
+/** Allocates the event ring.  Events before this are not
+   recorded. */
+void trace_init(void) {
+  struct thread *t = thread_current();
+
+  trace_thread_name(t->tid, t->name);
+  events = palloc_get_multiple(PAL_ZERO, TRACE_PAGES);
+  if (events == NULL) printf("trace: no memory for event ring, tracing disabled\n");
+}
+
+/** Appends an event of the given TYPE and ARG to the ring. */
+void trace_record(enum trace_type type, uint32_t arg) {
+  enum intr_level old_level;
+  struct trace_event *e;
+
+  if (events == NULL) return;
+
+  old_level = intr_disable();
+  e = &events[event_head++ & (TRACE_CNT - 1)];
+  e->tsc = rdtsc();
+  e->type = type;
+  e->tid = thread_current()->tid;
+  e->arg = arg;
+  intr_set_level(old_level);
+}
+
+/** Remembers that thread TID is called NAME. */
+void trace_thread_name(int tid, const char *name) {
+  struct trace_name *n = &names[tid & (NAME_CNT - 1)];
+
+  n->tid = tid;
+  strlcpy(n->name, name, sizeof n->name);
+}
+
+#ifdef FILESYS
+/** Sequential writer of sectors on a block device. */
+struct dump {
+  struct block *block;            /**< Device. */
+  block_sector_t sector;          /**< Next sector to write. */
+  size_t ofs;                     /**< Bytes in BUF. */
+  uint8_t buf[BLOCK_SECTOR_SIZE]; /**< Partial sector. */
+};
+
+/** Writes out D's partial sector, padded with zeros, if it has
+   anything in it. */
+static void dump_flush(struct dump *d) {
+  if (d->ofs == 0) return;
+  memset(d->buf + d->ofs, 0, BLOCK_SECTOR_SIZE - d->ofs);
+  block_write(d->block, d->sector++, d->buf);
+  d->ofs = 0;
+}
+
+/** Appends the SIZE bytes at DATA to D. */
+static void dump_write(struct dump *d, const void *data, size_t size) {
+  const uint8_t *p = data;
+
+  while (size > 0) {
+    size_t chunk = BLOCK_SECTOR_SIZE - d->ofs < size ? BLOCK_SECTOR_SIZE - d->ofs : size;
+
+    memcpy(d->buf + d->ofs, p, chunk);
+    d->ofs += chunk;
+    p += chunk;
+    size -= chunk;
+    if (d->ofs == BLOCK_SECTOR_SIZE) dump_flush(d);
+  }
+}
+
+/** Writes the ring to the scratch device, if -trace was given.
+   Stops recording events first. */
+void trace_dump(void) {
+  static struct dump d;
+  struct trace_header h;
+  struct trace_event *ring = events;
+  uint32_t first, i;
+  size_t sectors;
+
+  if (!trace_dump_at_exit || ring == NULL) return;
+  events = NULL;
+
+  d.block = block_get_role(BLOCK_SCRATCH);
+  if (d.block == NULL) {
+    printf("trace: no scratch device, trace not dumped\n");
+    return;
+  }
+
+  memset(&h, 0, sizeof h);
+  h.magic = TRACE_MAGIC;
+  h.version = TRACE_VERSION;
+  h.event_size = sizeof(struct trace_event);
+  h.event_cnt = event_head < TRACE_CNT ? event_head : TRACE_CNT;
+  h.lost_cnt = event_head - h.event_cnt;
+  h.name_cnt = NAME_CNT;
+  h.tsc_hz = timer_tsc_hz();
+
+  sectors = 1 + DIV_ROUND_UP(sizeof names, BLOCK_SECTOR_SIZE)
+            + DIV_ROUND_UP(h.event_cnt * sizeof(struct trace_event), BLOCK_SECTOR_SIZE);
+  if (sectors > block_size(d.block)) {
+    printf("trace: scratch device %s too small, need %zu sectors\n", block_name(d.block), sectors);
+    return;
+  }
+
+  d.sector = 0;
+  d.ofs = 0;
+  dump_write(&d, &h, sizeof h);
+  dump_flush(&d);
+  dump_write(&d, names, sizeof names);
+  dump_flush(&d);
+  first = event_head - h.event_cnt;
+  for (i = 0; i < h.event_cnt; i++) dump_write(&d, &ring[(first + i) & (TRACE_CNT - 1)], sizeof *ring);
+  dump_flush(&d);
+
+  printf("trace: %" PRIu32 " events (%" PRIu32 " lost) dumped to %s\n", h.event_cnt, h.lost_cnt, block_name(d.block));
+}
+#else
+/** Without a file system there are no block devices to dump to,
+   and no -trace option. */
+void trace_dump(void) {}
+#endif
+#endif /**< TRACE */
@@ -0,0 +1,52 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Kernel event tracing.
+
+   A tracepoint, TRACE_EVENT (TYPE, ARG), appends a 16-byte
+   record to a fixed-size ring in memory: the time-stamp counter,
+   the event type, the running thread's tid, and a 32-bit
+   argument.  Once the ring is full, new events overwrite the
+   oldest.  Given the -trace option, the kernel writes the ring to
+   the scratch device at shutdown, and utils/pintos-trace turns
+   it into Chrome trace JSON for a timeline viewer.
+
+   Tracepoints are compiled in only with "make TRACE=1", which
+   defines TRACE; otherwise they expand to nothing. */
+
+/** Event types.  utils/pintos-trace.c knows these by number. */
+enum trace_type {
+  TRACE_SWITCH = 1,   /**< Switched to this thread, from thread ARG. */
+  TRACE_BLOCK,        /**< Thread blocked. */
+  TRACE_UNBLOCK,      /**< Thread ARG was unblocked. */
+  TRACE_LOCK_WAIT,    /**< Waiting for the lock at address ARG. */
+  TRACE_LOCK_ACQUIRE, /**< Acquired the lock at ARG after waiting. */
+  TRACE_PAGE_FAULT,   /**< Page fault at address ARG. */
+  TRACE_READ_BEGIN,   /**< Started reading sector ARG of a block device. */
+  TRACE_READ_END,     /**< Finished reading sector ARG. */
+  TRACE_WRITE_BEGIN,  /**< Started writing sector ARG of a block device. */
+  TRACE_WRITE_END,    /**< Finished writing sector ARG. */
+};
+
+#ifdef TRACE
+#define TRACE_EVENT(TYPE, ARG) trace_record(TRACE_##TYPE, (uint32_t)(ARG))
+
+extern bool trace_dump_at_exit;
+
+void trace_init(void);
+void trace_record(enum trace_type, uint32_t arg);
+void trace_thread_name(int tid, const char *name);
+void trace_dump(void);
+#else
+#define TRACE_EVENT(TYPE, ARG) ((void)0)
+
+static inline void trace_init(void) {}
+static inline void trace_thread_name(int tid UNUSED, const char *name UNUSED) {}
+static inline void trace_dump(void) {}
+#endif
+
+#endif /**< threads/trace.h */
@@ -0,0 +1,384 @@
+#include "threads/workqueue.h"
+
+#include <debug.h>
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** Most threads in the pool that runs WORK_HIGH, WORK_NORMAL and
+   WORK_LOW items. */
+#define WORKER_MAX 4
+
+/** A set of worker threads serving a range of queues.  Queued
+   items are taken from the lowest-numbered, that is highest
+   priority, nonempty queue in FIRST...LAST. */
+struct pool {
+  const char *name;         /**< Base name of worker threads. */
+  enum work_priority first; /**< Highest priority served. */
+  enum work_priority last;  /**< Lowest priority served. */
+  int worker_max;           /**< Most workers. */
+  int worker_cnt;           /**< Workers started. */
+  int idle_cnt;             /**< Workers waiting on `sema'. */
+  int pending_cnt;          /**< Items queued but not yet taken. */
+  struct semaphore sema;    /**< Upped once per queued item. */
+};
+
+/** A worker thread. */
+struct worker {
+  struct list_elem elem; /**< Element in `workers'. */
+  struct pool *pool;     /**< Pool it belongs to. */
+  struct work *current;  /**< Item being run, or NULL. */
+  int priority;          /**< Thread priority set for `current'. */
+};
+
+/** A thread waiting in work_flush(). */
+struct flusher {
+  struct list_elem elem; /**< Element in `flushers'. */
+  struct semaphore sema; /**< Upped whenever an item finishes. */
+};
+
+/** Thread priority at which each work priority runs. */
+static const int work_thread_priority[WORK_PRI_CNT] = {PRI_MAX, PRI_DEFAULT + 1, PRI_DEFAULT, PRI_DEFAULT - 1};
+
+/** Everything below is protected by disabling interrupts, since
+   items may be queued from interrupt handlers. */
+static struct list queues[WORK_PRI_CNT]; /**< Queued items, by priority. */
+static struct rb_tree delayed;           /**< Delayed items, soonest first. */
+static struct list workers;              /**< All workers. */
+static struct list flushers;             /**< Threads in work_flush(). */
+static struct pool bh_pool;              /**< Runs bottom halves. */
+static struct pool main_pool;            /**< Runs everything else. */
+static bool initialized;                 /**< workqueue_init() done? */
+
+/** Statistics. */
+static long long run_cnt; /**< Items run. */
+
+static void pool_init(struct pool *, const char *name, enum work_priority first, enum work_priority last, int worker_max);
+static struct pool *pool_of(const struct work *);
+static bool enqueue(struct work *);
+static void wake(struct pool *, bool start);
+static void start_worker(struct pool *);
+static void wake_flushers(void);
+static bool is_running(const struct work *);
+static thread_func worker NO_RETURN;
+static rb_less_func work_due_less;
+
+/** Initializes the work queues and starts the bottom-half thread
+   and the first worker of the pool.  Must be called after the
+   thread system is started. */
+void workqueue_init(void) {
+  int i;
+
+  for (i = 0; i < WORK_PRI_CNT; i++) list_init(&queues[i]);
+  list_init(&workers);
+  list_init(&flushers);
+  pool_init(&bh_pool, "bottom-half", WORK_BH, WORK_BH, 1);
+  pool_init(&main_pool, "worker", WORK_HIGH, WORK_LOW, WORKER_MAX);
+
+  /* Insertion into `delayed' happens with interrupts off, but
+     the timer interrupt reads it before we get here. */
+  enum intr_level old_level = intr_disable();
+  rb_init(&delayed, work_due_less, NULL, NULL);
+  initialized = true;
+  intr_set_level(old_level);
+
+  start_worker(&bh_pool);
+  start_worker(&main_pool);
+}
+
+/** Called by the timer interrupt handler at each timer tick.
+   Queues delayed items that are due at tick NOW. */
+void workqueue_tick(int64_t now) {
+  struct rb_node *n;
+
+  ASSERT(intr_context());
+
+  while ((n = rb_first(&delayed)) != NULL) {
+    struct work *w = rb_entry(n, struct work, node);
+
+    if (w->due > now) break;
+    rb_remove(&delayed, n);
+    w->state = WORK_IDLE;
+    if (enqueue(w)) wake(pool_of(w), false);
+  }
+}
+
+/** Prints work queue statistics. */
+void workqueue_print_stats(void) {
+  printf("Workqueue: %lld items run, %d workers\n", run_cnt, main_pool.worker_cnt + bh_pool.worker_cnt);
+}
+
+/** Initializes W as an idle work item that calls FUNC when run
+   at priority PRIORITY. */
+void work_init(struct work *w, work_func *func, enum work_priority priority) {
+  ASSERT(w != NULL);
+  ASSERT(func != NULL);
+  ASSERT(priority < WORK_PRI_CNT);
+
+  w->func = func;
+  w->priority = priority;
+  w->due = 0;
+  w->state = WORK_IDLE;
+}
+
+/** Queues W to be run by a worker.  Returns true if successful,
+   false if W was already pending.
+
+   May be called from an interrupt handler.  Otherwise, this may
+   start another worker if every worker is busy. */
+bool work_queue(struct work *w) {
+  enum intr_level old_level;
+  bool queued;
+
+  ASSERT(initialized);
+
+  old_level = intr_disable();
+  queued = enqueue(w);
+  intr_set_level(old_level);
+
+  if (queued) wake(pool_of(w), !intr_context());
+  return queued;
+}
+
+/** Queues W to be run by a worker after TICKS timer ticks, or
+   right away if TICKS is not positive.  Returns true if
+   successful, false if W was already pending.  May be called
+   from an interrupt handler. */
+bool work_queue_delayed(struct work *w, int64_t ticks) {
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT(initialized);
+
+  if (ticks <= 0) return work_queue(w);
+
+  old_level = intr_disable();
+  if (w->state == WORK_IDLE) {
+    w->due = timer_ticks() + ticks;
+    w->state = WORK_DELAYED;
+    rb_insert(&delayed, &w->node);
+    queued = true;
+  }
+  intr_set_level(old_level);
+
+  return queued;
+}
+
+/** Takes W off its queue, if it is pending, so that it does not
+   run.  Returns true if W was pending, false otherwise.  If W's
+   function is already running, it keeps running; use
+   work_flush() to wait for it.  May be called from an interrupt
+   handler. */
+bool work_cancel(struct work *w) {
+  enum intr_level old_level = intr_disable();
+  bool cancelled = true;
+
+  switch (w->state) {
+    case WORK_IDLE:
+      cancelled = false;
+      break;
+
+    case WORK_DELAYED:
+      rb_remove(&delayed, &w->node);
+      break;
+
+    case WORK_QUEUED:
+      list_remove(&w->elem);
+      pool_of(w)->pending_cnt--;
+      sema_try_down(&pool_of(w)->sema);
+      break;
+  }
+  w->state = WORK_IDLE;
+  intr_set_level(old_level);
+
+  if (cancelled) wake_flushers();
+  return cancelled;
+}
+
+/** Waits until W is neither pending nor running.  A delayed item
+   is waited for until it has run.  Must not be called by W's own
+   function, or by any work function on behalf of an item that
+   runs in the same pool. */
+void work_flush(struct work *w) {
+  ASSERT(!intr_context());
+
+  for (;;) {
+    struct flusher f;
+    enum intr_level old_level = intr_disable();
+
+    if (w->state == WORK_IDLE && !is_running(w)) {
+      intr_set_level(old_level);
+      return;
+    }
+    sema_init(&f.sema, 0);
+    list_push_back(&flushers, &f.elem);
+    intr_set_level(old_level);
+
+    sema_down(&f.sema);
+  }
+}
+
+/** Returns true if W is queued or delayed, false otherwise. */
+bool work_pending(const struct work *w) { return w->state != WORK_IDLE; }
+
+/** Initializes pool P, named NAME, to run items of priorities
+   FIRST...LAST in at most WORKER_MAX threads. */
+static void pool_init(struct pool *p, const char *name, enum work_priority first, enum work_priority last, int worker_max) {
+  p->name = name;
+  p->first = first;
+  p->last = last;
+  p->worker_max = worker_max;
+  p->worker_cnt = p->idle_cnt = p->pending_cnt = 0;
+  sema_init(&p->sema, 0);
+}
+
+/** Returns the pool that runs W. */
+static struct pool *pool_of(const struct work *w) { return w->priority == WORK_BH ? &bh_pool : &main_pool; }
+
+/** Appends W to its queue and returns true, or returns false if
+   W is already pending.  Interrupts must be off. */
+static bool enqueue(struct work *w) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (w->state != WORK_IDLE) return false;
+  w->state = WORK_QUEUED;
+  list_push_back(&queues[w->priority], &w->elem);
+  pool_of(w)->pending_cnt++;
+  return true;
+}
+
+/** Wakes a worker in pool P for a newly queued item.  If START
+   is true and there are more queued items than idle workers,
+   also starts a new worker, unless P is at its limit.  START
+   must be false in an interrupt handler, which cannot create
+   threads. */
+static void wake(struct pool *p, bool start) {
+  if (intr_context()) {
+    sema_up_intr(&p->sema);
+    if (p == &bh_pool) intr_yield_on_return();
+    return;
+  }
+
+  if (start && p->pending_cnt > p->idle_cnt && p->worker_cnt < p->worker_max) start_worker(p);
+  sema_up(&p->sema);
+}
+
+/** Starts another worker thread in pool P, if P is not at its
+   limit. */
+static void start_worker(struct pool *p) {
+  enum intr_level old_level = intr_disable();
+  char name[16];
+  int n;
+
+  if (p->worker_cnt >= p->worker_max) {
+    intr_set_level(old_level);
+    return;
+  }
+  n = ++p->worker_cnt;
+  intr_set_level(old_level);
+
+  snprintf(name, sizeof name, p->worker_max > 1 ? "%s-%d" : "%s", p->name, n);
+  if (thread_create(name, work_thread_priority[p->first], worker, p) == TID_ERROR) {
+    old_level = intr_disable();
+    p->worker_cnt--;
+    intr_set_level(old_level);
+  }
+}
+
+/** Wakes every thread waiting in work_flush(), to check whether
+   its item is done. */
+static void wake_flushers(void) {
+  enum intr_level old_level;
+  struct list woken;
+
+  list_init(&woken);
+  old_level = intr_disable();
+  while (!list_empty(&flushers)) list_push_back(&woken, list_pop_front(&flushers));
+  intr_set_level(old_level);
+
+  while (!list_empty(&woken)) {
+    struct flusher *f = container_of(list_pop_front(&woken), struct flusher, elem);
+
+    if (intr_context())
+      sema_up_intr(&f->sema);
+    else
+      sema_up(&f->sema);
+  }
+}
+
+/** Returns true if a worker is running W's function.
+   Interrupts must be off. */
+static bool is_running(const struct work *w) {
+  struct list_elem *e;
+
+  for (e = list_begin(&workers); e != list_end(&workers); e = list_next(e))
+    if (container_of(e, struct worker, elem)->current == w) return true;
+  return false;
+}
+
+/** A worker thread in pool P_, which runs queued items forever. */
+static void worker(void *p_) {
+  struct worker self;
+  enum intr_level old_level;
+
+  self.pool = p_;
+  self.current = NULL;
+  self.priority = thread_get_priority();
+  old_level = intr_disable();
+  list_push_back(&workers, &self.elem);
+  intr_set_level(old_level);
+
+  for (;;) {
+    struct pool *p = self.pool;
+    struct work *w = NULL;
+    int i;
+
+    /* Take the highest-priority item, or wait for one. */
+    old_level = intr_disable();
+    for (i = p->first; i <= (int)p->last && w == NULL; i++)
+      if (!list_empty(&queues[i])) w = container_of(list_pop_front(&queues[i]), struct work, elem);
+    if (w == NULL) {
+      p->idle_cnt++;
+      intr_set_level(old_level);
+
+      /* Wait at the pool's highest priority, not that of the
+         last item run, so that whatever is queued next is not
+         held up behind threads it should preempt. */
+      if (self.priority != work_thread_priority[p->first]) {
+        self.priority = work_thread_priority[p->first];
+        thread_set_priority(self.priority);
+      }
+      sema_down(&p->sema);
+      old_level = intr_disable();
+      p->idle_cnt--;
+      intr_set_level(old_level);
+      continue;
+    }
+    w->state = WORK_IDLE;
+    p->pending_cnt--;
+    self.current = w;
+    intr_set_level(old_level);
+
+    if (self.priority != work_thread_priority[w->priority]) {
+      self.priority = work_thread_priority[w->priority];
+      thread_set_priority(self.priority);
+    }
+    w->func(w);
+
+    /* W may have been freed by its function, so do not touch
+       it from here on. */
+    old_level = intr_disable();
+    run_cnt++;
+    self.current = NULL;
+    intr_set_level(old_level);
+    wake_flushers();
+  }
+}
+
+/** Returns true if delayed item A is due before B. */
+static bool work_due_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct work, node)->due < rb_entry(b, struct work, node)->due;
+}
@@ -0,0 +1,87 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+/** Deferred work.
+
+   A "work item" is a function to be called later in a kernel
+   thread, where it may sleep, take locks and allocate memory.
+   Rather than creating a thread of its own, which costs a page,
+   a subsystem embeds a struct work in its data and queues it:
+
+      static struct work flush_work;
+
+      static void
+      flush_func (struct work *w UNUSED)
+      {
+        ...write out dirty blocks...
+      }
+
+      work_init (&flush_work, flush_func, WORK_LOW);
+      ...
+      work_queue (&flush_work);
+
+   A small pool of worker threads takes queued items, highest
+   priority first, and FIFO within a priority.  Workers are
+   started as needed, up to a fixed limit.  The function finds
+   its own data from the struct work with container_of().
+
+   An item is queued at most once at a time: queuing an item that
+   is already pending does nothing and returns false.  An item
+   may be queued again while its function runs, including by the
+   function itself, and it then runs again afterward.
+
+   work_queue_delayed() queues an item after a number of timer
+   ticks, for periodic or rate-limited work.
+
+   Bottom halves.  work_queue() and work_queue_delayed() may be
+   called from an interrupt handler.  Items of priority WORK_BH
+   run in a thread of their own at PRI_MAX, which preempts the
+   interrupted thread as soon as the handler returns.  An
+   interrupt handler can thus acknowledge the device and leave
+   the rest of its work to a bottom half that can block. */
+
+#include <list.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Work priorities, highest first. */
+enum work_priority {
+  WORK_BH,     /**< Bottom half of an interrupt handler. */
+  WORK_HIGH,   /**< Latency-sensitive work. */
+  WORK_NORMAL, /**< Ordinary work. */
+  WORK_LOW,    /**< Background work, such as write-back. */
+  WORK_PRI_CNT /**< Number of priorities. */
+};
+
+struct work;
+
+/** Function called to do work item W. */
+typedef void work_func(struct work *w);
+
+/** A work item. */
+struct work {
+  struct list_elem elem;       /**< Element in a queue. */
+  struct rb_node node;         /**< Node in the delayed work tree. */
+  work_func *func;             /**< Function to call. */
+  enum work_priority priority; /**< Queue to run in. */
+  int64_t due;                 /**< Tick to queue at, if delayed. */
+  enum {
+    WORK_IDLE,    /**< Not pending. */
+    WORK_DELAYED, /**< Waiting for its tick. */
+    WORK_QUEUED   /**< Waiting for a worker. */
+  } state;
+};
+
+void workqueue_init(void);
+void workqueue_tick(int64_t ticks);
+void workqueue_print_stats(void);
+
+void work_init(struct work *, work_func *, enum work_priority);
+bool work_queue(struct work *);
+bool work_queue_delayed(struct work *, int64_t ticks);
+bool work_cancel(struct work *);
+void work_flush(struct work *);
+bool work_pending(const struct work *);
+
+#endif /**< threads/workqueue.h */
@@ -5,7 +5,12 @@
 
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/vaddr.h"
 #include "userprog/gdt.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /** Number of page faults processed. */
 static long long page_fault_cnt;
@@ -119,6 +124,7 @@ static void page_fault(struct intr_frame *f) {
   bool write;       /**< True: access was write, false: access was read. */
   bool user;        /**< True: access by user, false: access by kernel. */
   void *fault_addr; /**< Fault address. */
+  struct thread *t = thread_current();
 
   /* Obtain faulting address, the virtual address that was
      accessed to cause the fault.  It may point to code or to
@@ -135,12 +141,40 @@ static void page_fault(struct intr_frame *f) {
 
   /* Count page faults. */
   page_fault_cnt++;
+  t->stats.page_faults++;
+  TRACE_EVENT(PAGE_FAULT, fault_addr);
 
   /* Determine cause. */
   not_present = (f->error_code & PF_P) == 0;
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* A not-present user page may simply not have been brought in
+     yet.  This also covers the kernel touching user memory on a
+     process's behalf. */
+  if (not_present && is_user_vaddr(fault_addr) && t->pagedir != NULL) {
+    /* The kernel only touches user memory inside system calls,
+       which record the user stack pointer on entry. */
+    void *esp = user ? f->esp : t->syscall_frame != NULL ? t->syscall_frame->esp : PHYS_BASE;
+
+    if (page_load(fault_addr) || page_grow_stack(fault_addr, esp)) return;
+  }
+
+  /* A write to a present page that is read-only only because
+     fork() left its frame shared. */
+  if (!not_present && write && is_user_vaddr(fault_addr) && t->pagedir != NULL && page_unshare(fault_addr)) return;
+#endif
+
+  /* A system call passed a bad user pointer.  The copy routines in
+     userprog/syscall.c keep the address to resume at in EAX; they
+     see -1 there and kill the process. */
+  if (!user && is_user_vaddr(fault_addr) && t->syscall_frame != NULL) {
+    f->eip = (void (*)(void))f->eax;
+    f->eax = 0xffffffff;
+    return;
+  }
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
@@ -1,44 +1,123 @@
 #include "userprog/pagedir.h"
 
+#include <bitmap.h>
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
 #include "threads/init.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+/** Largest batch that pagedir_batch_end() invalidates a page at a
+   time.  Beyond this, reloading CR3 is cheaper.  Thanks to global
+   pages, that costs only the user entries. */
+#define BATCH_INVLPG_MAX 16
+
+/** Most zeroed page table pages kept for reuse. */
+#define PT_CACHE_MAX 16
+
+/** Bookkeeping for a page directory made by pagedir_create(). */
+struct pagedir {
+  uint32_t *pd;               /**< The page directory itself. */
+  struct bitmap *used;        /**< User PDEs that point to a page table. */
+  struct hash_elem elem;      /**< Element in `pagedirs'. */
+  struct list_elem reap_elem; /**< Element in `reap_list'. */
+};
+
+static struct lock pagedir_lock;         /**< Protects the variables below. */
+static struct hash pagedirs;             /**< Live page directories. */
+static struct list reap_list;            /**< Destroyed directories not yet freed. */
+static struct work reap_work;            /**< Frees everything in `reap_list'. */
+static uint32_t *pt_cache[PT_CACHE_MAX]; /**< Zeroed page table pages. */
+static size_t pt_cache_cnt;              /**< Number of pages in pt_cache. */
 
 static uint32_t *active_pd(void);
-static void invalidate_pagedir(uint32_t *);
+static void invalidate_page(uint32_t *, const void *vaddr);
+static void invlpg(uintptr_t vaddr);
+static struct pagedir *pagedir_find(uint32_t *pd);
+static uint32_t *pt_alloc(void);
+static void pt_free(uint32_t *pt);
+static void *get_page(enum palloc_flags);
+static bool reap_next(void);
+static void reap(struct pagedir *);
+static work_func reaper;
+static hash_hash_func pagedir_hash;
+static hash_less_func pagedir_less;
+
+/** Initializes page directory bookkeeping. */
+void pagedir_init(void) {
+  lock_init(&pagedir_lock);
+  list_init(&reap_list);
+  work_init(&reap_work, reaper, WORK_LOW);
+  if (!hash_init(&pagedirs, pagedir_hash, pagedir_less, NULL)) PANIC("pagedir_init: out of memory");
+}
 
 /** Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
    Returns the new page directory, or a null pointer if memory
    allocation fails. */
 uint32_t *pagedir_create(void) {
-  uint32_t *pd = palloc_get_page(0);
-  if (pd != NULL) memcpy(pd, init_page_dir, PGSIZE);
+  struct pagedir *p;
+  uint32_t *pd;
+
+  pd = get_page(0);
+  if (pd == NULL) return NULL;
+
+  p = malloc(sizeof *p);
+  if (p == NULL) goto fail;
+  p->used = bitmap_create(pd_no(PHYS_BASE));
+  if (p->used == NULL) goto fail;
+  p->pd = pd;
+  memcpy(pd, init_page_dir, PGSIZE);
+
+  lock_acquire(&pagedir_lock);
+  hash_insert(&pagedirs, &p->elem);
+  lock_release(&pagedir_lock);
   return pd;
+
+fail:
+  free(p);
+  palloc_free_page(pd);
+  return NULL;
 }
 
 /** Destroys page directory PD, freeing all the pages it
-   references. */
+   references.  PD must not be active.  The memory is actually
+   freed a little later, by a worker thread, so that the
+   exiting process need not wait for it. */
 void pagedir_destroy(uint32_t *pd) {
-  uint32_t *pde;
+  struct pagedir *p;
 
   if (pd == NULL) return;
 
   ASSERT(pd != init_page_dir);
-  for (pde = pd; pde < pd + pd_no(PHYS_BASE); pde++)
-    if (*pde & PTE_P) {
-      uint32_t *pt = pde_get_pt(*pde);
-      uint32_t *pte;
+  ASSERT(pd != active_pd());
+
+  lock_acquire(&pagedir_lock);
+  p = pagedir_find(pd);
+  hash_delete(&pagedirs, &p->elem);
+  list_push_back(&reap_list, &p->reap_elem);
+  lock_release(&pagedir_lock);
+  work_queue(&reap_work);
+}
 
-      for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
-        if (*pte & PTE_P) palloc_free_page(pte_get_page(*pte));
-      palloc_free_page(pt);
-    }
-  palloc_free_page(pd);
+/** Frees every page directory that pagedir_destroy() has handed
+   to the worker but that it has not yet gotten to.  Returns true
+   if any memory was freed.  Callers that fail to allocate memory
+   should call this and retry before giving up. */
+bool pagedir_reclaim(void) {
+  bool freed = false;
+
+  while (reap_next()) freed = true;
+  return freed;
 }
 
 /** Returns the address of the page table entry for virtual
@@ -60,14 +139,23 @@ static uint32_t *lookup_page(uint32_t *pd, const void *vaddr, bool create) {
   pde = pd + pd_no(vaddr);
   if (*pde == 0) {
     if (create) {
-      pt = palloc_get_page(PAL_ZERO);
+      struct pagedir *p;
+
+      pt = pt_alloc();
       if (pt == NULL) return NULL;
 
+      lock_acquire(&pagedir_lock);
+      p = pagedir_find(pd);
+      bitmap_mark(p->used, pde - pd);
+      lock_release(&pagedir_lock);
       *pde = pde_create(pt);
     } else
       return NULL;
   }
 
+  /* The kernel's 4 MB pages have no page table entries. */
+  if (*pde & PTE_PS) return NULL;
+
   /* Return the page table entry. */
   pt = pde_get_pt(*pde);
   return &pt[pt_no(vaddr)];
@@ -131,10 +219,69 @@ void pagedir_clear_page(uint32_t *pd, void *upage) {
   pte = lookup_page(pd, upage, false);
   if (pte != NULL && (*pte & PTE_P) != 0) {
     *pte &= ~PTE_P;
-    invalidate_pagedir(pd);
+    invalidate_page(pd, upage);
   }
 }
 
+/** Makes the mapping of user virtual page UPAGE in PD read/write
+   if WRITABLE is true, read-only otherwise.  Other bits in the
+   page table entry are preserved.  UPAGE need not be mapped. */
+void pagedir_set_writable(uint32_t *pd, void *upage, bool writable) {
+  uint32_t *pte;
+
+  ASSERT(pg_ofs(upage) == 0);
+  ASSERT(is_user_vaddr(upage));
+
+  pte = lookup_page(pd, upage, false);
+  if (pte != NULL && (*pte & PTE_P) != 0) {
+    if (writable)
+      *pte |= PTE_W;
+    else {
+      *pte &= ~(uint32_t)PTE_W;
+      invalidate_page(pd, upage);
+    }
+  }
+}
+
+/** Maps a private copy of every user page mapped in SRC at the
+   same address and with the same writability in DST.  Returns
+   false if memory allocation fails, in which case DST holds the
+   pages copied so far and must still be destroyed. */
+bool pagedir_dup(uint32_t *dst, uint32_t *src) {
+  struct bitmap *used;
+  size_t i;
+
+  lock_acquire(&pagedir_lock);
+  used = pagedir_find(src)->used;
+  lock_release(&pagedir_lock);
+
+  for (i = bitmap_scan(used, 0, 1, true); i != BITMAP_ERROR; i = bitmap_scan(used, i + 1, 1, true)) {
+    uint32_t *pt = pde_get_pt(src[i]);
+    uint32_t *pte;
+
+    for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
+      if (*pte & PTE_P) {
+        void *upage = (void *)(((uintptr_t)i << PDSHIFT) | ((uintptr_t)(pte - pt) << PTSHIFT));
+        void *kpage = get_page(PAL_USER);
+
+        if (kpage == NULL) return false;
+        memcpy(kpage, pte_get_page(*pte), PGSIZE);
+        if (!pagedir_set_page(dst, upage, kpage, (*pte & PTE_W) != 0)) {
+          palloc_free_page(kpage);
+          return false;
+        }
+      }
+  }
+  return true;
+}
+
+/** Returns true if PD maps virtual page VPAGE writable.
+   Returns false if PD contains no PTE for VPAGE. */
+bool pagedir_is_writable(uint32_t *pd, const void *vpage) {
+  uint32_t *pte = lookup_page(pd, vpage, false);
+  return pte != NULL && (*pte & PTE_P) != 0 && (*pte & PTE_W) != 0;
+}
+
 /** Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -153,7 +300,7 @@ void pagedir_set_dirty(uint32_t *pd, const void *vpage, bool dirty) {
       *pte |= PTE_D;
     else {
       *pte &= ~(uint32_t)PTE_D;
-      invalidate_pagedir(pd);
+      invalidate_page(pd, vpage);
     }
   }
 }
@@ -176,7 +323,7 @@ void pagedir_set_accessed(uint32_t *pd, const void *vpage, bool accessed) {
       *pte |= PTE_A;
     else {
       *pte &= ~(uint32_t)PTE_A;
-      invalidate_pagedir(pd);
+      invalidate_page(pd, vpage);
     }
   }
 }
@@ -205,18 +352,164 @@ static uint32_t *active_pd(void) {
   return ptov(pd);
 }
 
-/** Seom page table changes can cause the CPU's translation
+/** Starts a batch of page table changes in the current thread's
+   page directory, such as unmapping a range of pages.  Until the
+   matching pagedir_batch_end(), invalidating a TLB entry only
+   widens the range that pagedir_batch_end() will invalidate.
+   Calls may nest.
+
+   The batch must not return to user mode, nor read or write a user
+   page that it has unmapped, before it ends. */
+void pagedir_batch_begin(void) { thread_current()->tlb_batch++; }
+
+/** Ends a batch started by pagedir_batch_begin(), invalidating the
+   TLB entries of every page it changed, either one at a time or,
+   for a large range, all at once by reloading CR3. */
+void pagedir_batch_end(void) {
+  struct thread *t = thread_current();
+
+  ASSERT(t->tlb_batch > 0);
+  if (--t->tlb_batch == 0 && t->tlb_start < t->tlb_end) {
+    if ((t->tlb_end - t->tlb_start) / PGSIZE <= BATCH_INVLPG_MAX) {
+      uintptr_t vaddr;
+
+      for (vaddr = t->tlb_start; vaddr < t->tlb_end; vaddr += PGSIZE) invlpg(vaddr);
+    } else
+      pagedir_activate(active_pd());
+    t->tlb_start = t->tlb_end = 0;
+  }
+}
+
+/** Some page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
-   table.  When this happens, we have to "invalidate" the TLB by
-   re-activating it.
-
-   This function invalidates the TLB if PD is the active page
-   directory.  (If PD is not active then its entries are not in
-   the TLB, so there is no need to invalidate anything.) */
-static void invalidate_pagedir(uint32_t *pd) {
-  if (active_pd() == pd) {
-    /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
-       "Translation Lookaside Buffers (TLBs)". */
-    pagedir_activate(pd);
+   table.  When this happens, we have to "invalidate" the TLB
+   entry for the page whose PTE changed.
+
+   This function invalidates the entry for VADDR if PD is the
+   active page directory.  (If PD is not active then its entries
+   are not in the TLB, so there is no need to invalidate
+   anything.)  Inside a batch, it only records VADDR for
+   pagedir_batch_end(). */
+static void invalidate_page(uint32_t *pd, const void *vaddr) {
+  struct thread *t;
+  uintptr_t page = (uintptr_t)pg_round_down(vaddr);
+
+  if (active_pd() != pd) return;
+
+  t = thread_current();
+  if (t->tlb_batch == 0)
+    invlpg(page);
+  else if (t->tlb_start == t->tlb_end) {
+    t->tlb_start = page;
+    t->tlb_end = page + PGSIZE;
+  } else {
+    if (page < t->tlb_start) t->tlb_start = page;
+    if (page + PGSIZE > t->tlb_end) t->tlb_end = page + PGSIZE;
+  }
+}
+
+/** Invalidates the TLB entry for the page containing VADDR.  See
+   [IA32-v2a] "INVLPG". */
+static void invlpg(uintptr_t vaddr) { asm volatile("invlpg %0" : : "m"(*(char *)vaddr) : "memory"); }
+
+/** Returns the bookkeeping for page directory PD.
+   pagedir_lock must be held. */
+static struct pagedir *pagedir_find(uint32_t *pd) {
+  struct pagedir p;
+  struct hash_elem *e;
+
+  ASSERT(lock_held_by_current_thread(&pagedir_lock));
+
+  p.pd = pd;
+  e = hash_find(&pagedirs, &p.elem);
+  ASSERT(e != NULL);
+  return hash_entry(e, struct pagedir, elem);
+}
+
+/** Returns a zeroed page for use as a page table, preferably
+   one recycled from a destroyed page directory, or a null
+   pointer if memory is exhausted. */
+static uint32_t *pt_alloc(void) {
+  uint32_t *pt = NULL;
+
+  lock_acquire(&pagedir_lock);
+  if (pt_cache_cnt > 0) pt = pt_cache[--pt_cache_cnt];
+  lock_release(&pagedir_lock);
+
+  return pt != NULL ? pt : get_page(PAL_ZERO);
+}
+
+/** Gives back page table PT, which must be all zeros, keeping it
+   for pt_alloc() if there is room in the cache. */
+static void pt_free(uint32_t *pt) {
+  lock_acquire(&pagedir_lock);
+  if (pt_cache_cnt < PT_CACHE_MAX) {
+    pt_cache[pt_cache_cnt++] = pt;
+    pt = NULL;
+  }
+  lock_release(&pagedir_lock);
+
+  palloc_free_page(pt);
+}
+
+/** Obtains a page with palloc_get_page(FLAGS), reclaiming
+   destroyed page directories and trying again if none is
+   free. */
+static void *get_page(enum palloc_flags flags) {
+  void *page = palloc_get_page(flags);
+
+  if (page == NULL && pagedir_reclaim()) page = palloc_get_page(flags);
+  return page;
+}
+
+/** Frees the oldest page directory waiting on reap_list.
+   Returns false if there was none. */
+static bool reap_next(void) {
+  struct pagedir *p = NULL;
+
+  lock_acquire(&pagedir_lock);
+  if (!list_empty(&reap_list)) p = container_of(list_pop_front(&reap_list), struct pagedir, reap_elem);
+  lock_release(&pagedir_lock);
+
+  if (p == NULL) return false;
+  reap(p);
+  return true;
+}
+
+/** Frees page directory P along with every page it maps.  Only
+   the page tables recorded in P's bitmap are visited, and each
+   is cleared as it is walked so that it can be recycled. */
+static void reap(struct pagedir *p) {
+  size_t i;
+
+  for (i = bitmap_scan(p->used, 0, 1, true); i != BITMAP_ERROR; i = bitmap_scan(p->used, i + 1, 1, true)) {
+    uint32_t *pt = pde_get_pt(p->pd[i]);
+    uint32_t *pte;
+
+    for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
+      if (*pte != 0) {
+        if (*pte & PTE_P) palloc_free_page(pte_get_page(*pte));
+        *pte = 0;
+      }
+    pt_free(pt);
   }
+
+  palloc_free_page(p->pd);
+  bitmap_destroy(p->used);
+  free(p);
+}
+
+/** Work function that frees page directories handed to
+   pagedir_destroy(). */
+static void reaper(struct work *w UNUSED) { pagedir_reclaim(); }
+
+/** Returns a hash value for the page directory of E. */
+static unsigned pagedir_hash(const struct hash_elem *e, void *aux UNUSED) {
+  const struct pagedir *p = hash_entry(e, struct pagedir, elem);
+  return hash_bytes(&p->pd, sizeof p->pd);
+}
+
+/** Returns true if the page directory of A precedes that of B. */
+static bool pagedir_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+  return hash_entry(a, struct pagedir, elem)->pd < hash_entry(b, struct pagedir, elem)->pd;
 }
@@ -0,0 +1,238 @@
+#include "userprog/pipe.h"
+
+#include <debug.h>
+
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#endif
+
+/** Pipes.
+
+   A pipe is a queue of up to PIPE_PAGES pages of data.  The
+   writer copies into the last page until it is full and then
+   starts another; the reader copies out of the first page and
+   retires it once it is empty, keeping the page for reuse.
+
+   A page that is full and unread can be given to the reader
+   whole instead of copied, if the reader's buffer has a page
+   boundary there and room for a page: the page is mapped into
+   the reader's address space in place of the buffer page, which
+   the pipe keeps in exchange.  Bulk transfers between processes
+   then cost a single copy, on the writer's side.
+
+   Pages come from the user pool, since they change hands with
+   user pages.  With VM, they are frames, pinned while the pipe
+   has them. */
+
+/** Most pages of data in a pipe. */
+#define PIPE_PAGES 8
+
+/** One page of a pipe. */
+struct pipe_buf {
+  void *kpage; /**< Page, or null if not allocated yet. */
+#ifdef VM
+  struct frame *frame; /**< Frame whose page KPAGE is. */
+#endif
+  size_t ofs; /**< Bytes already read. */
+  size_t len; /**< Bytes written. */
+};
+
+/** A pipe. */
+struct pipe {
+  struct lock lock;                 /**< Protects everything below. */
+  struct condition readable;        /**< Signaled when data arrives or writers go away. */
+  struct condition writable;        /**< Signaled when room appears or readers go away. */
+  int readers;                      /**< Open read ends. */
+  int writers;                      /**< Open write ends. */
+  struct pipe_buf bufs[PIPE_PAGES]; /**< Ring of pages. */
+  size_t first;                     /**< Index in BUFS of the page being read. */
+  size_t cnt;                       /**< Number of pages in use, from FIRST. */
+};
+
+static bool buf_alloc(struct pipe_buf *);
+static void buf_free(struct pipe_buf *);
+static bool buf_flip(struct pipe_buf *, void *upage);
+
+/** Creates and returns a new pipe with one read end and one
+   write end open, or returns a null pointer if memory allocation
+   fails. */
+struct pipe *pipe_create(void) {
+  struct pipe *p = calloc(1, sizeof *p);
+
+  if (p != NULL) {
+    lock_init(&p->lock);
+    cond_init(&p->readable);
+    cond_init(&p->writable);
+    p->readers = p->writers = 1;
+  }
+  return p;
+}
+
+/** Opens another read end of P, or write end if WRITER is
+   true. */
+void pipe_dup(struct pipe *p, bool writer) {
+  lock_acquire(&p->lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release(&p->lock);
+}
+
+/** Closes a read end of P, or write end if WRITER is true.
+   Frees P once both kinds of ends are all closed. */
+void pipe_close(struct pipe *p, bool writer) {
+  bool dead;
+  size_t i;
+
+  lock_acquire(&p->lock);
+  if (writer)
+    p->writers--;
+  else
+    p->readers--;
+  cond_broadcast(&p->readable, &p->lock);
+  cond_broadcast(&p->writable, &p->lock);
+  dead = p->readers == 0 && p->writers == 0;
+  lock_release(&p->lock);
+
+  if (dead) {
+    for (i = 0; i < PIPE_PAGES; i++) buf_free(&p->bufs[i]);
+    free(p);
+  }
+}
+
+/** Reads up to SIZE bytes from P into user buffer UDST.  Waits
+   until P holds data or has no writers left, and then stores the
+   number of bytes read, which is 0 at end of file, in *CNT.
+   Returns false if UDST is not valid user memory. */
+bool pipe_read(struct pipe *p, void *udst, size_t size, int *cnt) {
+  uint8_t *dst = udst;
+  size_t total = 0;
+
+  lock_acquire(&p->lock);
+  while (size > 0 && p->cnt == 0 && p->writers > 0) cond_wait(&p->readable, &p->lock);
+
+  while (total < size && p->cnt > 0) {
+    struct pipe_buf *b = &p->bufs[p->first];
+    size_t n = b->len - b->ofs;
+
+    if (b->ofs == 0 && n == PGSIZE && pg_ofs(dst + total) == 0 && size - total >= PGSIZE && buf_flip(b, dst + total))
+      ;
+    else {
+      if (n > size - total) n = size - total;
+      if (!syscall_copy_out(dst + total, (uint8_t *)b->kpage + b->ofs, n)) {
+        lock_release(&p->lock);
+        return false;
+      }
+    }
+    b->ofs += n;
+    total += n;
+
+    if (b->ofs == b->len) {
+      b->ofs = b->len = 0;
+      p->first = (p->first + 1) % PIPE_PAGES;
+      p->cnt--;
+    }
+  }
+
+  cond_broadcast(&p->writable, &p->lock);
+  lock_release(&p->lock);
+  *cnt = total;
+  return true;
+}
+
+/** Writes the SIZE bytes in user buffer USRC to P, waiting for
+   room as necessary, and stores the number of bytes written in
+   *CNT.  That is less than SIZE only if the last read end is
+   closed or memory runs out meanwhile, and -1 if nothing could be
+   written.  Returns false if USRC is not valid user memory. */
+bool pipe_write(struct pipe *p, const void *usrc, size_t size, int *cnt) {
+  const uint8_t *src = usrc;
+  size_t total = 0;
+
+  lock_acquire(&p->lock);
+  while (total < size) {
+    struct pipe_buf *b;
+    size_t n;
+
+    while (p->readers > 0 && p->cnt == PIPE_PAGES && p->bufs[(p->first + p->cnt - 1) % PIPE_PAGES].len == PGSIZE)
+      cond_wait(&p->writable, &p->lock);
+    if (p->readers == 0) break;
+
+    /* Append to the last page, or start a new one. */
+    b = p->cnt > 0 ? &p->bufs[(p->first + p->cnt - 1) % PIPE_PAGES] : NULL;
+    if (b == NULL || b->len == PGSIZE) {
+      b = &p->bufs[(p->first + p->cnt) % PIPE_PAGES];
+      if (b->kpage == NULL && !buf_alloc(b)) break;
+    }
+
+    n = PGSIZE - b->len;
+    if (n > size - total) n = size - total;
+    if (!syscall_copy_in((uint8_t *)b->kpage + b->len, src + total, n)) {
+      lock_release(&p->lock);
+      return false;
+    }
+    if (b->len == 0) p->cnt++;
+    b->len += n;
+    total += n;
+    cond_broadcast(&p->readable, &p->lock);
+  }
+  lock_release(&p->lock);
+  *cnt = total > 0 || size == 0 ? (int)total : -1;
+  return true;
+}
+
+/** Gives B a page.  Returns false if none is available. */
+static bool buf_alloc(struct pipe_buf *b) {
+#ifdef VM
+  b->frame = frame_alloc();
+  b->kpage = b->frame != NULL ? b->frame->kpage : NULL;
+#else
+  b->kpage = palloc_get_page(PAL_USER);
+  if (b->kpage == NULL && pagedir_reclaim()) b->kpage = palloc_get_page(PAL_USER);
+#endif
+  return b->kpage != NULL;
+}
+
+/** Frees B's page, if it has one. */
+static void buf_free(struct pipe_buf *b) {
+  if (b->kpage == NULL) return;
+#ifdef VM
+  lock_acquire(&frame_lock);
+  frame_free(b->frame);
+  lock_release(&frame_lock);
+#else
+  palloc_free_page(b->kpage);
+#endif
+  b->kpage = NULL;
+}
+
+/** Maps B's page into the current process at UPAGE, in place of
+   the page there, which B gets instead.  Returns false, changing
+   nothing, if UPAGE is not a writable page of the process's own. */
+static bool buf_flip(struct pipe_buf *b, void *upage) {
+#ifdef VM
+  if (!page_flip(upage, &b->frame)) return false;
+  b->kpage = b->frame->kpage;
+#else
+  uint32_t *pd = thread_current()->pagedir;
+  void *old = pagedir_get_page(pd, upage);
+  bool success;
+
+  if (old == NULL || !pagedir_is_writable(pd, upage)) return false;
+  pagedir_clear_page(pd, upage);
+  success = pagedir_set_page(pd, upage, b->kpage, true);
+  ASSERT(success);
+  b->kpage = old;
+#endif
+  thread_current()->stats.page_flips++;
+  return true;
+}
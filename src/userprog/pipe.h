@@ -0,0 +1,15 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct pipe;
+
+struct pipe *pipe_create(void);
+void pipe_dup(struct pipe *, bool writer);
+void pipe_close(struct pipe *, bool writer);
+bool pipe_read(struct pipe *, void *udst, size_t size, int *cnt);
+bool pipe_write(struct pipe *, const void *usrc, size_t size, int *cnt);
+
+#endif /**< userprog/pipe.h */
@@ -13,52 +13,138 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/pipe.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
+
+/** Exit status of a process, shared between the process and its
+   parent so that it outlives whichever of the two exits first. */
+struct child_status {
+  tid_t tid;             /**< Child's thread id. */
+  int exit_status;       /**< Set by exit(), -1 if killed. */
+  struct semaphore dead; /**< Upped when the child exits. */
+  int ref_cnt;           /**< Number of parent and child still alive. */
+  bool started;          /**< Print an exit line when the child exits? */
+  struct list_elem elem; /**< Element in parent's `children'. */
+};
+
+/** Information passed from process_execute() to the child. */
+struct exec_args {
+  char *cmd_line;              /**< Program name and arguments. */
+  struct child_status *status; /**< Child's exit status. */
+  struct semaphore loaded;     /**< Upped once load() has finished. */
+  bool success;                /**< Did load() succeed? */
+};
+
+/** Information passed from process_fork() to the child. */
+struct fork_args {
+  struct thread *parent;       /**< Process being duplicated. */
+  struct intr_frame if_;       /**< Parent's user context at the system call. */
+  struct child_status *status; /**< Child's exit status. */
+  struct semaphore done;       /**< Upped once the child has its copy. */
+  bool success;                /**< Did the copy succeed? */
+};
+
+/** An open file descriptor: a file or one end of a pipe. */
+struct fd_entry {
+  struct file *file; /**< Open file, or null. */
+  struct pipe *pipe; /**< Pipe, or null. */
+  bool writer;       /**< Is PIPE open for writing, rather than reading? */
+};
+
+/** Most open files per process: the file table is one page. */
+#define FD_MAX ((int)(PGSIZE / sizeof(struct fd_entry)))
 
 static thread_func start_process NO_RETURN;
-static bool load(const char *cmdline, void (**eip)(void), void **esp);
+static thread_func start_fork NO_RETURN;
+static bool load(char *cmd_line, void (**eip)(void), void **esp);
+static struct child_status *child_status_create(void);
+static void child_status_release(struct child_status *);
+static void child_status_add(struct child_status *, tid_t);
+static bool copy_files(struct thread *parent);
+static int fd_alloc(void);
 
 /** Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
-tid_t process_execute(const char *file_name) {
-  char *fn_copy;
+   CMD_LINE, which holds the program name followed by its
+   arguments, separated by spaces.  Waits until the program is
+   loaded.  Returns the new process's thread id, or TID_ERROR if
+   the thread cannot be created or the program cannot be
+   loaded. */
+tid_t process_execute(const char *cmd_line) {
+  struct exec_args args;
+  char name[16];
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
+  /* Make a copy of CMD_LINE.
      Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page(0);
-  if (fn_copy == NULL) return TID_ERROR;
-  strlcpy(fn_copy, file_name, PGSIZE);
-
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create(file_name, PRI_DEFAULT, start_process, fn_copy);
-  if (tid == TID_ERROR) palloc_free_page(fn_copy);
+  args.cmd_line = palloc_get_page(0);
+  if (args.cmd_line == NULL) return TID_ERROR;
+  strlcpy(args.cmd_line, cmd_line, PGSIZE);
+
+  args.status = child_status_create();
+  if (args.status == NULL) {
+    palloc_free_page(args.cmd_line);
+    return TID_ERROR;
+  }
+  sema_init(&args.loaded, 0);
+  args.success = false;
+
+  /* The thread is named after the program, without arguments. */
+  cmd_line += strspn(cmd_line, " ");
+  strlcpy(name, cmd_line, sizeof name);
+  name[strcspn(name, " ")] = '\0';
+
+  /* Create a new thread to execute CMD_LINE. */
+  tid = thread_create(name, PRI_DEFAULT, start_process, &args);
+  if (tid == TID_ERROR) {
+    palloc_free_page(args.cmd_line);
+    free(args.status);
+    return TID_ERROR;
+  }
+  sema_down(&args.loaded);
+  if (!args.success) {
+    child_status_release(args.status);
+    return TID_ERROR;
+  }
+  child_status_add(args.status, tid);
   return tid;
 }
 
 /** A thread function that loads a user process and starts it
    running. */
-static void start_process(void *file_name_) {
-  char *file_name = file_name_;
+static void start_process(void *args_) {
+  struct exec_args *args = args_;
   struct intr_frame if_;
   bool success;
 
+  /* A process that fails to load still exits with -1, as
+     far as its parent and the exit line are concerned. */
+  thread_current()->child = args->status;
+  args->status->started = true;
+
   /* Initialize interrupt frame and load executable. */
   memset(&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load(file_name, &if_.eip, &if_.esp);
+  success = load(args->cmd_line, &if_.eip, &if_.esp);
 
-  /* If load failed, quit. */
-  palloc_free_page(file_name);
+  /* ARGS lives on the parent's stack: don't touch it after
+     waking the parent.  If load failed, quit. */
+  palloc_free_page(args->cmd_line);
+  args->success = success;
+  sema_up(&args->loaded);
   if (!success) thread_exit();
 
   /* Start the user process by simulating a return from an
@@ -71,25 +157,171 @@ static void start_process(void *file_name_) {
   NOT_REACHED();
 }
 
+/** Creates a child process that is a duplicate of the current
+   one, which entered the kernel with user context IF_.  The child
+   resumes from the same point with 0 as the system call's return
+   value.  Returns the child's thread id, or TID_ERROR if the
+   child cannot be created.
+
+   The parent blocks until the child has finished copying its
+   address space, so nothing in it changes during the copy. */
+tid_t process_fork(const struct intr_frame *if_) {
+  struct thread *cur = thread_current();
+  struct fork_args args;
+  tid_t tid;
+
+  args.parent = cur;
+  args.if_ = *if_;
+  args.status = child_status_create();
+  if (args.status == NULL) return TID_ERROR;
+  sema_init(&args.done, 0);
+  args.success = false;
+
+  tid = thread_create(cur->name, PRI_DEFAULT, start_fork, &args);
+  if (tid == TID_ERROR) {
+    free(args.status);
+    return TID_ERROR;
+  }
+  sema_down(&args.done);
+  if (!args.success) {
+    child_status_release(args.status);
+    return TID_ERROR;
+  }
+  child_status_add(args.status, tid);
+  return tid;
+}
+
+/** A thread function that copies the parent's address space and
+   open files and returns to user mode where the parent made its
+   fork() system call. */
+static void start_fork(void *args_) {
+  struct fork_args *args = args_;
+  struct thread *parent = args->parent;
+  struct thread *t = thread_current();
+  struct intr_frame if_ = args->if_;
+  bool success = false;
+
+  t->child = args->status;
+  if_.eax = 0;
+
+#ifdef VM
+  if (!page_table_init(&t->pages)) goto done;
+  t->next_mapid = 0;
+  mmap_fork(parent);
+#endif
+  t->pagedir = pagedir_create();
+  if (t->pagedir == NULL) goto done;
+  process_activate();
+
+  lock_acquire(&filesys_lock);
+  success = copy_files(parent);
+  lock_release(&filesys_lock);
+  if (!success) goto done;
+
+#ifdef VM
+  success = page_table_copy(parent);
+#else
+  success = pagedir_dup(t->pagedir, parent->pagedir);
+#endif
+
+done:
+  /* ARGS lives on the parent's stack: don't touch it after
+     waking the parent.  If the copy failed, fork() returns
+     PID_ERROR, so no process ever existed to print an exit
+     line. */
+  t->child->started = success;
+  args->success = success;
+  sema_up(&args->done);
+  if (!success) thread_exit();
+
+  asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(&if_) : "memory");
+  NOT_REACHED();
+}
+
+/** Gives the current process its own copy of PARENT's executable
+   and open files.  Each file is reopened at the same position, so
+   unlike on Unix the two processes' positions are independent
+   afterward.  Pipes are shared.  filesys_lock must be held. */
+static bool copy_files(struct thread *parent) {
+  struct thread *t = thread_current();
+  int fd;
+
+  if (parent->exec_file != NULL) {
+    t->exec_file = file_reopen(parent->exec_file);
+    if (t->exec_file == NULL) return false;
+    file_deny_write(t->exec_file);
+  }
+
+  if (parent->files != NULL) {
+    t->files = palloc_get_page(PAL_ZERO);
+    if (t->files == NULL) return false;
+    for (fd = 0; fd < FD_MAX; fd++)
+      if (parent->files[fd].file != NULL) {
+        t->files[fd].file = file_reopen(parent->files[fd].file);
+        if (t->files[fd].file == NULL) return false;
+        file_seek(t->files[fd].file, file_tell(parent->files[fd].file));
+      } else if (parent->files[fd].pipe != NULL) {
+        t->files[fd] = parent->files[fd];
+        pipe_dup(t->files[fd].pipe, t->files[fd].writer);
+      }
+  }
+  return true;
+}
+
 /** Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
+   immediately, without waiting. */
+int process_wait(tid_t child_tid) {
+  struct list *children = &thread_current()->children;
+  struct list_elem *e;
+
+  for (e = list_begin(children); e != list_end(children); e = list_next(e)) {
+    struct child_status *cs = container_of(e, struct child_status, elem);
+
+    if (cs->tid == child_tid) {
+      int status;
+
+      sema_down(&cs->dead);
+      status = cs->exit_status;
+      list_remove(&cs->elem);
+      child_status_release(cs);
+      return status;
+    }
+  }
+  return -1;
+}
 
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
-int process_wait(tid_t child_tid UNUSED) { return -1; }
+/** Records STATUS as the current process's exit status, to be
+   reported to its parent when it exits. */
+void process_set_exit_status(int status) {
+  struct thread *cur = thread_current();
+
+  if (cur->child != NULL) cur->child->exit_status = status;
+}
 
 /** Free the current process's resources. */
 void process_exit(void) {
   struct thread *cur = thread_current();
   uint32_t *pd;
+  int fd;
+
+  if (cur->child != NULL && cur->child->started) printf("%s: exit(%d)\n", cur->name, cur->child->exit_status);
+
+  pd = cur->pagedir;
+#ifdef VM
+  /* Write back memory mapped files and release resident pages
+     while the page directory that maps them is still in place.
+     The page table may exist without a page directory, if
+     creating the page directory failed. */
+  if (pd != NULL) mmap_unmap_all();
+  if (rhash_initialized(&cur->pages)) page_table_destroy(&cur->pages);
+#endif
 
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
-  pd = cur->pagedir;
   if (pd != NULL) {
     /* Correct ordering here is crucial.  We must set
        cur->pagedir to NULL before switching page directories,
@@ -102,6 +334,31 @@ void process_exit(void) {
     pagedir_activate(NULL);
     pagedir_destroy(pd);
   }
+
+  /* Only now that nothing maps it may the executable be closed
+     and written again. */
+  if (cur->files != NULL)
+    for (fd = 0; fd < FD_MAX; fd++)
+      if (cur->files[fd].pipe != NULL) pipe_close(cur->files[fd].pipe, cur->files[fd].writer);
+  if (cur->files != NULL || cur->exec_file != NULL) {
+    lock_acquire(&filesys_lock);
+    if (cur->files != NULL) {
+      for (fd = 0; fd < FD_MAX; fd++) file_close(cur->files[fd].file);
+      palloc_free_page(cur->files);
+      cur->files = NULL;
+    }
+    file_close(cur->exec_file);
+    cur->exec_file = NULL;
+    lock_release(&filesys_lock);
+  }
+
+  /* Orphan our children and wake our parent. */
+  while (!list_empty(&cur->children)) child_status_release(container_of(list_pop_front(&cur->children), struct child_status, elem));
+  if (cur->child != NULL) {
+    sema_up(&cur->child->dead);
+    child_status_release(cur->child);
+    cur->child = NULL;
+  }
 }
 
 /** Sets up the CPU for running user code in the current
@@ -118,6 +375,112 @@ void process_activate(void) {
   tss_update();
 }
 
+/** Returns the lowest free file descriptor of the current
+   process, or -1 if the table is full or cannot be allocated. */
+static int fd_alloc(void) {
+  struct thread *cur = thread_current();
+  int fd;
+
+  if (cur->files == NULL && (cur->files = palloc_get_page(PAL_ZERO)) == NULL) return -1;
+
+  /* 0 and 1 are the console. */
+  for (fd = 2; fd < FD_MAX; fd++)
+    if (cur->files[fd].file == NULL && cur->files[fd].pipe == NULL) return fd;
+  return -1;
+}
+
+/** Adds FILE to the current process's open files and returns its
+   file descriptor, or -1 if the table is full. */
+int process_file_add(struct file *file) {
+  int fd = fd_alloc();
+
+  if (fd != -1) thread_current()->files[fd].file = file;
+  return fd;
+}
+
+/** Returns the current process's open file FD, or a null pointer
+   if FD is not open or is a pipe. */
+struct file *process_file_get(int fd) {
+  struct thread *cur = thread_current();
+
+  return cur->files != NULL && fd >= 0 && fd < FD_MAX ? cur->files[fd].file : NULL;
+}
+
+/** Removes FD from the current process's open files and returns
+   the file, which the caller must close, or a null pointer if FD
+   is not an open file. */
+struct file *process_file_remove(int fd) {
+  struct file *file = process_file_get(fd);
+
+  if (file != NULL) thread_current()->files[fd].file = NULL;
+  return file;
+}
+
+/** Adds the read end of PIPE, or the write end if WRITER is true,
+   to the current process's open files and returns its file
+   descriptor, or -1 if the table is full. */
+int process_pipe_add(struct pipe *pipe, bool writer) {
+  int fd = fd_alloc();
+
+  if (fd != -1) {
+    thread_current()->files[fd].pipe = pipe;
+    thread_current()->files[fd].writer = writer;
+  }
+  return fd;
+}
+
+/** Returns the pipe that the current process has open as FD and
+   stores in *WRITER whether FD is its write end, or returns a
+   null pointer if FD is not a pipe. */
+struct pipe *process_pipe_get(int fd, bool *writer) {
+  struct thread *cur = thread_current();
+
+  if (cur->files == NULL || fd < 0 || fd >= FD_MAX || cur->files[fd].pipe == NULL) return NULL;
+  *writer = cur->files[fd].writer;
+  return cur->files[fd].pipe;
+}
+
+/** Removes FD from the current process's open files and returns
+   the pipe, which the caller must close with pipe_close(), storing
+   in *WRITER whether FD was its write end.  Returns a null pointer
+   if FD is not a pipe. */
+struct pipe *process_pipe_remove(int fd, bool *writer) {
+  struct pipe *pipe = process_pipe_get(fd, writer);
+
+  if (pipe != NULL) thread_current()->files[fd].pipe = NULL;
+  return pipe;
+}
+
+/** Returns a new child_status for a child that is about to be
+   created, or a null pointer if memory allocation fails. */
+static struct child_status *child_status_create(void) {
+  struct child_status *cs = malloc(sizeof *cs);
+
+  if (cs != NULL) {
+    cs->tid = TID_ERROR;
+    cs->exit_status = -1;
+    sema_init(&cs->dead, 0);
+    cs->ref_cnt = 2;
+    cs->started = false;
+  }
+  return cs;
+}
+
+/** Records that the parent now knows CS as child TID. */
+static void child_status_add(struct child_status *cs, tid_t tid) {
+  cs->tid = tid;
+  list_push_back(&thread_current()->children, &cs->elem);
+}
+
+/** Drops the parent's or the child's reference to CS. */
+static void child_status_release(struct child_status *cs) {
+  enum intr_level old_level = intr_disable();
+  bool dead = --cs->ref_cnt == 0;
+
+  intr_set_level(old_level);
+  if (dead) free(cs);
+}
+
 /** We load ELF binaries.  The following definitions are taken
    from the ELF specification, [ELF1], more-or-less verbatim.  */
 
@@ -180,26 +543,42 @@ struct Elf32_Phdr {
 #define PF_R 4 /**< Readable. */
 
 static bool setup_stack(void **esp);
+static bool push_args(void **esp, char *cmd_line);
 static bool validate_segment(const struct Elf32_Phdr *, struct file *);
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable);
 
-/** Loads an ELF executable from FILE_NAME into the current thread.
+/** Loads the ELF executable named by the first word of CMD_LINE
+   into the current thread, and passes it the words of CMD_LINE as
+   arguments.  CMD_LINE is modified.
    Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
    Returns true if successful, false otherwise. */
-bool load(const char *file_name, void (**eip)(void), void **esp) {
+static bool load(char *cmd_line, void (**eip)(void), void **esp) {
   struct thread *t = thread_current();
   struct Elf32_Ehdr ehdr;
   struct file *file = NULL;
+  char file_name[NAME_MAX + 1];
   off_t file_ofs;
-  bool success = false;
   int i;
 
+  cmd_line += strspn(cmd_line, " ");
+  strlcpy(file_name, cmd_line, sizeof file_name);
+  file_name[strcspn(file_name, " ")] = '\0';
+
   /* Allocate and activate page directory. */
+#ifdef VM
+  if (!page_table_init(&t->pages)) return false;
+  t->next_mapid = 0;
+#endif
   t->pagedir = pagedir_create();
-  if (t->pagedir == NULL) goto done;
+  if (t->pagedir == NULL) return false;
   process_activate();
 
+  /* The file system is only touched with filesys_lock held, and
+     the lock is dropped before the stack is set up: that may
+     need a frame, and evicting one may write to a file. */
+  lock_acquire(&filesys_lock);
+
   /* Open executable file. */
   file = filesys_open(file_name);
   if (file == NULL) {
@@ -261,23 +640,31 @@ bool load(const char *file_name, void (**eip)(void), void **esp) {
     }
   }
 
+  /* On success the executable stays open, and unwritable, until
+     process_exit(): its pages are read in as they are touched. */
+  file_deny_write(file);
+  t->exec_file = file;
+  lock_release(&filesys_lock);
+
   /* Set up stack. */
-  if (!setup_stack(esp)) goto done;
+  if (!setup_stack(esp) || !push_args(esp, cmd_line)) return false;
 
   /* Start address. */
   *eip = (void (*)(void))ehdr.e_entry;
-
-  success = true;
+  return true;
 
 done:
-  /* We arrive here whether the load is successful or not. */
+  /* We arrive here if reading the executable failed. */
   file_close(file);
-  return success;
+  lock_release(&filesys_lock);
+  return false;
 }
 
 /** load() helpers. */
 
+#ifndef VM
 static bool install_page(void *upage, void *kpage, bool writable);
+#endif
 
 /** Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -326,6 +713,10 @@ static bool validate_segment(const struct Elf32_Phdr *phdr, struct file *file) {
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With VM the pages are only recorded in the supplemental page
+   table here, and page_fault() reads each one in on first
+   access.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable) {
@@ -333,6 +724,21 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
   ASSERT(pg_ofs(upage) == 0);
   ASSERT(ofs % PGSIZE == 0);
 
+#ifdef VM
+  while (read_bytes > 0 || zero_bytes > 0) {
+    size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+    size_t page_zero_bytes = PGSIZE - page_read_bytes;
+
+    if (!page_add_file(upage, file, ofs, page_read_bytes, writable)) return false;
+    mmap_reserve(upage, 1);
+
+    read_bytes -= page_read_bytes;
+    zero_bytes -= page_zero_bytes;
+    ofs += page_read_bytes;
+    upage += PGSIZE;
+  }
+  return true;
+#else
   file_seek(file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) {
     /* Calculate how to fill this page.
@@ -343,6 +749,7 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
 
     /* Get a page of memory. */
     uint8_t *kpage = palloc_get_page(PAL_USER);
+    if (kpage == NULL && pagedir_reclaim()) kpage = palloc_get_page(PAL_USER);
     if (kpage == NULL) return false;
 
     /* Load this page. */
@@ -364,15 +771,26 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
     upage += PGSIZE;
   }
   return true;
+#endif
 }
 
 /** Create a minimal stack by mapping a zeroed page at the top of
    user virtual memory. */
 static bool setup_stack(void **esp) {
+#ifdef VM
+  uint8_t *upage = ((uint8_t *)PHYS_BASE) - PGSIZE;
+
+  /* The first stack page is about to be written anyway, so bring
+     it in now rather than taking a fault for it. */
+  if (!page_add_zero(upage, true) || !page_load(upage)) return false;
+  *esp = PHYS_BASE;
+  return true;
+#else
   uint8_t *kpage;
   bool success = false;
 
   kpage = palloc_get_page(PAL_USER | PAL_ZERO);
+  if (kpage == NULL && pagedir_reclaim()) kpage = palloc_get_page(PAL_USER | PAL_ZERO);
   if (kpage != NULL) {
     success = install_page(((uint8_t *)PHYS_BASE) - PGSIZE, kpage, true);
     if (success)
@@ -381,8 +799,48 @@ static bool setup_stack(void **esp) {
       palloc_free_page(kpage);
   }
   return success;
+#endif
+}
+
+/** Pushes the words of CMD_LINE onto the user stack whose top is
+   *ESP, in the layout that _start() in lib/user/entry.c expects:
+   argc, argv, and a fake return address, with the argv[] array
+   and the strings it points to above them.  Returns false if they
+   do not fit in the first stack page. */
+static bool push_args(void **esp, char *cmd_line) {
+  uint8_t *bottom = (uint8_t *)PHYS_BASE - PGSIZE;
+  uint8_t *sp = *esp;
+  char *token, *save_ptr, *arg;
+  char **argv;
+  uint32_t *word;
+  int argc = 0, i;
+
+  /* The strings.  They end up in reverse order, the last argument
+     at the lowest address. */
+  for (token = strtok_r(cmd_line, " ", &save_ptr); token != NULL; token = strtok_r(NULL, " ", &save_ptr)) {
+    size_t size = strlen(token) + 1;
+
+    if (size > (size_t)(sp - bottom)) return false;
+    sp -= size;
+    memcpy(sp, token, size);
+    argc++;
+  }
+
+  /* argv[], word aligned, then argv, argc and the return address. */
+  argv = (char **)ROUND_DOWN((uintptr_t)sp, sizeof(char *)) - (argc + 1);
+  word = (uint32_t *)argv;
+  if ((uint8_t *)(word - 3) < bottom) return false;
+  argv[argc] = NULL;
+  for (i = argc - 1, arg = (char *)sp; i >= 0; i--, arg += strlen(arg) + 1) argv[i] = arg;
+  *--word = (uint32_t)argv;
+  *--word = argc;
+  *--word = 0;
+
+  *esp = word;
+  return true;
 }
 
+#ifndef VM
 /** Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -399,3 +857,4 @@ static bool install_page(void *upage, void *kpage, bool writable) {
      address, then map our page there. */
   return (pagedir_get_page(t->pagedir, upage) == NULL && pagedir_set_page(t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -1,11 +1,27 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include "threads/interrupt.h"
 #include "threads/thread.h"
 
-tid_t process_execute(const char *file_name);
+struct file;
+struct pipe;
+
+tid_t process_execute(const char *cmd_line);
+tid_t process_fork(const struct intr_frame *);
 int process_wait(tid_t);
+void process_set_exit_status(int);
 void process_exit(void);
 void process_activate(void);
 
+/** Open files. */
+int process_file_add(struct file *);
+struct file *process_file_get(int fd);
+struct file *process_file_remove(int fd);
+
+/** Pipes, which share the open files' descriptors. */
+int process_pipe_add(struct pipe *, bool writer);
+struct pipe *process_pipe_get(int fd, bool *writer);
+struct pipe *process_pipe_remove(int fd, bool *writer);
+
 #endif /**< userprog/process.h */
@@ -1,16 +1,573 @@
 #include "userprog/syscall.h"
 
+#include <debug.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 
+#include "devices/block.h"
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "devices/timer.h"
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/interrupt.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pipe.h"
+#include "userprog/process.h"
+#ifdef VM
+#include "vm/mmap.h"
+#endif
+
+/** System call dispatch.
+
+   The system call number and its arguments are words on the user
+   stack.  syscall_handler() copies in the number, checks it
+   against the table below, copies in as many argument words as
+   the table says, and calls the handler with them.
+
+   User memory is never checked page by page.  A user pointer is
+   only checked to lie below PHYS_BASE, and then used directly by
+   copy_user() or get_user().  If the access faults, page_fault()
+   sees a kernel fault on a user address and resumes the copy at
+   a recovery label, whose address the copy keeps in EAX, with EAX
+   set to -1.  Pages that are merely not resident are brought in
+   by page_fault() as usual. */
+
+struct lock filesys_lock;
+
+/** A system call handler.  ARGS holds the call's argument words.
+   The return value goes to the user in EAX. */
+typedef uint32_t syscall_func(const uint32_t args[]);
+
+static syscall_func sys_halt NO_RETURN, sys_exit NO_RETURN, sys_exec, sys_wait, sys_create, sys_remove, sys_open, sys_filesize, sys_read, sys_write, sys_seek,
+    sys_tell, sys_close, sys_mmap, sys_munmap, sys_chdir, sys_mkdir, sys_readdir, sys_isdir, sys_inumber, sys_fork,
+    sys_threadstats, sys_iostat, sys_pipe, sys_pread, sys_pwrite, sys_readv, sys_writev;
+
+/** System call table, indexed by system call number. */
+static const struct syscall {
+  syscall_func *func; /**< Handler. */
+  int arg_cnt;        /**< Number of argument words. */
+} syscalls[] = {
+    [SYS_HALT] = {sys_halt, 0},               /**< (void) */
+    [SYS_EXIT] = {sys_exit, 1},               /**< (status) */
+    [SYS_EXEC] = {sys_exec, 1},               /**< (file) */
+    [SYS_WAIT] = {sys_wait, 1},               /**< (pid) */
+    [SYS_CREATE] = {sys_create, 2},           /**< (file, initial_size) */
+    [SYS_REMOVE] = {sys_remove, 1},           /**< (file) */
+    [SYS_OPEN] = {sys_open, 1},               /**< (file) */
+    [SYS_FILESIZE] = {sys_filesize, 1},       /**< (fd) */
+    [SYS_READ] = {sys_read, 3},               /**< (fd, buffer, length) */
+    [SYS_WRITE] = {sys_write, 3},             /**< (fd, buffer, length) */
+    [SYS_SEEK] = {sys_seek, 2},               /**< (fd, position) */
+    [SYS_TELL] = {sys_tell, 1},               /**< (fd) */
+    [SYS_CLOSE] = {sys_close, 1},             /**< (fd) */
+    [SYS_MMAP] = {sys_mmap, 2},               /**< (fd, addr) */
+    [SYS_MUNMAP] = {sys_munmap, 1},           /**< (mapping) */
+    [SYS_CHDIR] = {sys_chdir, 1},             /**< (dir) */
+    [SYS_MKDIR] = {sys_mkdir, 1},             /**< (dir) */
+    [SYS_READDIR] = {sys_readdir, 2},         /**< (fd, name) */
+    [SYS_ISDIR] = {sys_isdir, 1},             /**< (fd) */
+    [SYS_INUMBER] = {sys_inumber, 1},         /**< (fd) */
+    [SYS_FORK] = {sys_fork, 0},               /**< (void) */
+    [SYS_THREADSTATS] = {sys_threadstats, 0}, /**< (void) */
+    [SYS_IOSTAT] = {sys_iostat, 1},           /**< (stats) */
+    [SYS_PIPE] = {sys_pipe, 1},               /**< (fds) */
+    [SYS_PREAD] = {sys_pread, 4},             /**< (fd, buffer, length, offset) */
+    [SYS_PWRITE] = {sys_pwrite, 4},           /**< (fd, buffer, length, offset) */
+    [SYS_READV] = {sys_readv, 3},             /**< (fd, iov, iovcnt) */
+    [SYS_WRITEV] = {sys_writev, 3},           /**< (fd, iov, iovcnt) */
+};
+
+/** Most argument words of any system call. */
+#define SYSCALL_MAX_ARGS 4
 
 static void syscall_handler(struct intr_frame *);
+static void kill(void) NO_RETURN;
+static void copy_in(void *dst, const void *usrc, size_t size);
+static void copy_out(void *udst, const void *src, size_t size);
+static char *copy_in_string(const char *ustr);
 
-void syscall_init(void) { intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall"); }
+void syscall_init(void) {
+  lock_init(&filesys_lock);
+  intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall");
+}
+
+static void syscall_handler(struct intr_frame *f) {
+  struct thread *t = thread_current();
+  const uint32_t *esp = f->esp;
+  uint32_t args[SYSCALL_MAX_ARGS];
+  uint32_t nr;
+
+  t->syscall_frame = f;
+  copy_in(&nr, esp, sizeof nr);
+  if (nr >= sizeof syscalls / sizeof *syscalls || syscalls[nr].func == NULL) kill();
+  copy_in(args, esp + 1, syscalls[nr].arg_cnt * sizeof *args);
+  f->eax = syscalls[nr].func(args);
+  t->syscall_frame = NULL;
+}
 
-static void syscall_handler(struct intr_frame *f UNUSED) {
-  printf("system call!\n");
+/** Terminates the current process with exit status -1. */
+static void kill(void) {
+  process_set_exit_status(-1);
   thread_exit();
 }
+
+/** Returns true if the SIZE bytes at UADDR all lie in user
+   virtual memory.  They need not be mapped. */
+static bool is_user_range(const void *uaddr, size_t size) {
+  uintptr_t start = (uintptr_t)uaddr;
+  return start + size >= start && start + size <= (uintptr_t)PHYS_BASE;
+}
+
+/** Copies SIZE bytes from SRC to DST, either of which may be a
+   checked user address.  Returns false if that faults. */
+static bool copy_user(void *dst, const void *src, size_t size) {
+  int result;
+
+  asm volatile("movl $1f, %%eax; rep movsb; xorl %%eax, %%eax; 1:" : "=&a"(result), "+D"(dst), "+S"(src), "+c"(size) : : "memory");
+  return result == 0;
+}
+
+/** Reads the byte at checked user address UADDR.  Returns the
+   byte, or -1 if that faults. */
+static inline int get_user(const uint8_t *uaddr) {
+  int result;
+
+  asm volatile("movl $1f, %0; movzbl %1, %0; 1:" : "=&a"(result) : "m"(*uaddr));
+  return result;
+}
+
+/** Copies SIZE bytes from user address USRC to DST, killing the
+   process if any of them is not mapped user memory. */
+static void copy_in(void *dst, const void *usrc, size_t size) {
+  if (!is_user_range(usrc, size) || !copy_user(dst, usrc, size)) kill();
+}
+
+/** Copies SIZE bytes from SRC to user address UDST, killing the
+   process if any of them is not mapped user memory. */
+static void copy_out(void *udst, const void *src, size_t size) {
+  if (!is_user_range(udst, size) || !copy_user(udst, src, size)) kill();
+}
+
+/** Copies SIZE bytes from user address USRC to DST.  Returns
+   false if any of them is not mapped user memory. */
+bool syscall_copy_in(void *dst, const void *usrc, size_t size) { return is_user_range(usrc, size) && copy_user(dst, usrc, size); }
+
+/** Copies SIZE bytes from SRC to user address UDST.  Returns
+   false if any of them is not mapped user memory. */
+bool syscall_copy_out(void *udst, const void *src, size_t size) { return is_user_range(udst, size) && copy_user(udst, src, size); }
+
+/** Copies the null-terminated string at user address USTR into a
+   new page and returns it; the caller must free it with
+   palloc_free_page().  Strings longer than a page are truncated.
+   Kills the process if USTR is not a valid string, and returns a
+   null pointer if memory allocation fails. */
+static char *copy_in_string(const char *ustr) {
+  char *kstr = palloc_get_page(0);
+  size_t i;
+
+  if (kstr == NULL) return NULL;
+  for (i = 0; i < PGSIZE; i++) {
+    int c = is_user_vaddr(ustr + i) ? get_user((const uint8_t *)ustr + i) : -1;
+
+    if (c == -1) {
+      palloc_free_page(kstr);
+      kill();
+    }
+    kstr[i] = c;
+    if (c == '\0') return kstr;
+  }
+  kstr[PGSIZE - 1] = '\0';
+  return kstr;
+}
+
+static uint32_t sys_halt(const uint32_t args[] UNUSED) { shutdown_power_off(); }
+
+static uint32_t sys_exit(const uint32_t args[]) {
+  process_set_exit_status(args[0]);
+  thread_exit();
+}
+
+static uint32_t sys_exec(const uint32_t args[]) {
+  char *cmd_line = copy_in_string((const char *)args[0]);
+  tid_t tid;
+
+  if (cmd_line == NULL) return TID_ERROR;
+  tid = process_execute(cmd_line);
+  palloc_free_page(cmd_line);
+  return tid;
+}
+
+static uint32_t sys_wait(const uint32_t args[]) { return process_wait(args[0]); }
+
+static uint32_t sys_create(const uint32_t args[]) {
+  char *name = copy_in_string((const char *)args[0]);
+  bool success;
+
+  if (name == NULL) return false;
+  lock_acquire(&filesys_lock);
+  success = filesys_create(name, args[1]);
+  lock_release(&filesys_lock);
+  palloc_free_page(name);
+  return success;
+}
+
+static uint32_t sys_remove(const uint32_t args[]) {
+  char *name = copy_in_string((const char *)args[0]);
+  bool success;
+
+  if (name == NULL) return false;
+  lock_acquire(&filesys_lock);
+  success = filesys_remove(name);
+  lock_release(&filesys_lock);
+  palloc_free_page(name);
+  return success;
+}
+
+static uint32_t sys_open(const uint32_t args[]) {
+  char *name = copy_in_string((const char *)args[0]);
+  struct file *file;
+  int fd = -1;
+
+  if (name == NULL) return -1;
+  lock_acquire(&filesys_lock);
+  file = filesys_open(name);
+  if (file != NULL) {
+    fd = process_file_add(file);
+    if (fd < 0) file_close(file);
+  }
+  lock_release(&filesys_lock);
+  palloc_free_page(name);
+  return fd;
+}
+
+static uint32_t sys_filesize(const uint32_t args[]) {
+  struct file *file = process_file_get(args[0]);
+  off_t length;
+
+  if (file == NULL) return -1;
+  lock_acquire(&filesys_lock);
+  length = file_length(file);
+  lock_release(&filesys_lock);
+  return length;
+}
+
+/** Where a read or write system call transfers data: the
+   console, a pipe, or a file at its own position or at OFS.
+   File data goes through PAGE, a bounce page, so that
+   filesys_lock is never held while touching user memory. */
+struct io {
+  struct file *file; /**< File, or null. */
+  struct pipe *pipe; /**< Pipe, or null.  Console if FILE is null too. */
+  off_t ofs;         /**< Position for pread() and pwrite(), or -1. */
+  uint8_t *page;     /**< Bounce page, unless PIPE is nonnull. */
+};
+
+/** Sets up IO for reading from FD, or writing if WRITING is
+   true, at OFS, or at the file's own position if OFS is -1.
+   Returns false if FD cannot be used that way, or if no bounce
+   page is available. */
+static bool io_begin(struct io *io, int fd, bool writing, off_t ofs) {
+  bool writer;
+
+  io->file = NULL;
+  io->ofs = ofs;
+  io->page = NULL;
+  if ((io->pipe = process_pipe_get(fd, &writer)) != NULL) return writer == writing && ofs == -1;
+  if (fd != (writing ? STDOUT_FILENO : STDIN_FILENO) && (io->file = process_file_get(fd)) == NULL) return false;
+  if (io->file == NULL && ofs != -1) return false;
+  io->page = palloc_get_page(0);
+  return io->page != NULL;
+}
+
+/** Releases IO's bounce page. */
+static void io_end(struct io *io) { palloc_free_page(io->page); }
+
+/** Kills the process for passing a bad buffer, after ending IO. */
+static void io_kill(struct io *io) NO_RETURN;
+static void io_kill(struct io *io) {
+  io_end(io);
+  kill();
+}
+
+/** Reads up to SIZE bytes through IO into user buffer UBUF, which
+   has been checked with is_user_range(), and returns the number
+   read, or -1 on a pipe error. */
+static int io_read(struct io *io, uint8_t *ubuf, unsigned size) {
+  unsigned total = 0;
+  int cnt;
+
+  if (io->pipe != NULL) {
+    if (!pipe_read(io->pipe, ubuf, size, &cnt)) io_kill(io);
+    return cnt;
+  }
+  while (total < size) {
+    unsigned chunk = size - total < PGSIZE ? size - total : PGSIZE;
+    unsigned n;
+
+    if (io->file == NULL) {
+      input_read(io->page, chunk);
+      n = chunk;
+    } else {
+      lock_acquire(&filesys_lock);
+      n = io->ofs == -1 ? file_read(io->file, io->page, chunk) : file_read_at(io->file, io->page, chunk, io->ofs);
+      lock_release(&filesys_lock);
+      if (io->ofs != -1) io->ofs += n;
+    }
+    if (!copy_user(ubuf + total, io->page, n)) io_kill(io);
+    total += n;
+    if (n < chunk) break;
+  }
+  return total;
+}
+
+/** Writes the SIZE bytes in user buffer UBUF, which has been
+   checked with is_user_range(), through IO.  Returns the number
+   written, or -1 on a pipe error.  Console output is written one
+   page at a time, so that short writes from different processes
+   are not interleaved. */
+static int io_write(struct io *io, const uint8_t *ubuf, unsigned size) {
+  unsigned total = 0;
+  int cnt;
+
+  if (io->pipe != NULL) {
+    if (!pipe_write(io->pipe, ubuf, size, &cnt)) io_kill(io);
+    return cnt;
+  }
+  while (total < size) {
+    unsigned chunk = size - total < PGSIZE ? size - total : PGSIZE;
+    unsigned n = chunk;
+
+    if (!copy_user(io->page, ubuf + total, chunk)) io_kill(io);
+    if (io->file == NULL)
+      putbuf((const char *)io->page, chunk);
+    else {
+      lock_acquire(&filesys_lock);
+      n = io->ofs == -1 ? file_write(io->file, io->page, chunk) : file_write_at(io->file, io->page, chunk, io->ofs);
+      lock_release(&filesys_lock);
+      if (io->ofs != -1) io->ofs += n;
+    }
+    total += n;
+    if (n < chunk) break;
+  }
+  return total;
+}
+
+/** Reads or writes the SIZE bytes at user address UBUF through
+   FD, at OFS or at FD's own position if OFS is -1. */
+static int transfer(int fd, void *ubuf, unsigned size, off_t ofs, bool writing) {
+  struct io io;
+  int cnt;
+
+  if (!is_user_range(ubuf, size)) kill();
+  if (!io_begin(&io, fd, writing, ofs)) {
+    io_end(&io);
+    return -1;
+  }
+  cnt = writing ? io_write(&io, ubuf, size) : io_read(&io, ubuf, size);
+  io_end(&io);
+  return cnt;
+}
+
+/** Layout of struct iovec in lib/user/syscall.h. */
+struct iovec {
+  void *base;
+  size_t len;
+};
+
+/** Most elements in an iovec array, as in lib/user/syscall.h. */
+#define IOV_MAX 64
+
+/** Reads or writes through FD the buffers described by the CNT
+   iovecs at user address UIOV, in order.  The iovecs are copied
+   in and checked all at once; a short transfer into or out of
+   one buffer ends the call. */
+static int transfer_vector(int fd, const struct iovec *uiov, int cnt, bool writing) {
+  struct iovec iov[IOV_MAX];
+  int total = 0;
+  struct io io;
+  int i;
+
+  if (cnt < 0 || cnt > IOV_MAX) return -1;
+  copy_in(iov, uiov, cnt * sizeof *iov);
+  for (i = 0; i < cnt; i++)
+    if (!is_user_range(iov[i].base, iov[i].len)) kill();
+
+  if (!io_begin(&io, fd, writing, -1)) {
+    io_end(&io);
+    return -1;
+  }
+  for (i = 0; i < cnt; i++) {
+    int n = writing ? io_write(&io, iov[i].base, iov[i].len) : io_read(&io, iov[i].base, iov[i].len);
+
+    if (n < 0) {
+      if (total == 0) total = -1;
+      break;
+    }
+    total += n;
+    if ((unsigned)n < iov[i].len) break;
+  }
+  io_end(&io);
+  return total;
+}
+
+static uint32_t sys_read(const uint32_t args[]) { return transfer(args[0], (void *)args[1], args[2], -1, false); }
+
+static uint32_t sys_write(const uint32_t args[]) { return transfer(args[0], (void *)args[1], args[2], -1, true); }
+
+static uint32_t sys_pread(const uint32_t args[]) {
+  if ((off_t)args[3] < 0) return -1;
+  return transfer(args[0], (void *)args[1], args[2], args[3], false);
+}
+
+static uint32_t sys_pwrite(const uint32_t args[]) {
+  if ((off_t)args[3] < 0) return -1;
+  return transfer(args[0], (void *)args[1], args[2], args[3], true);
+}
+
+static uint32_t sys_readv(const uint32_t args[]) { return transfer_vector(args[0], (const struct iovec *)args[1], args[2], false); }
+
+static uint32_t sys_writev(const uint32_t args[]) { return transfer_vector(args[0], (const struct iovec *)args[1], args[2], true); }
+
+static uint32_t sys_seek(const uint32_t args[]) {
+  struct file *file = process_file_get(args[0]);
+
+  if (file != NULL) {
+    lock_acquire(&filesys_lock);
+    file_seek(file, args[1]);
+    lock_release(&filesys_lock);
+  }
+  return 0;
+}
+
+static uint32_t sys_tell(const uint32_t args[]) {
+  struct file *file = process_file_get(args[0]);
+  off_t position;
+
+  if (file == NULL) return -1;
+  lock_acquire(&filesys_lock);
+  position = file_tell(file);
+  lock_release(&filesys_lock);
+  return position;
+}
+
+static uint32_t sys_close(const uint32_t args[]) {
+  struct file *file = process_file_remove(args[0]);
+  struct pipe *pipe;
+  bool writer;
+
+  if ((pipe = process_pipe_remove(args[0], &writer)) != NULL) pipe_close(pipe, writer);
+  if (file != NULL) {
+    lock_acquire(&filesys_lock);
+    file_close(file);
+    lock_release(&filesys_lock);
+  }
+  return 0;
+}
+
+static uint32_t sys_mmap(const uint32_t args[]) {
+#ifdef VM
+  struct file *file = process_file_get(args[0]);
+
+  return file != NULL ? mmap_map(file, (void *)args[1]) : -1;
+#else
+  (void)args;
+  return -1;
+#endif
+}
+
+static uint32_t sys_munmap(const uint32_t args[]) {
+#ifdef VM
+  mmap_unmap(args[0]);
+#else
+  (void)args;
+#endif
+  return 0;
+}
+
+/** Subdirectories are not implemented: there is only the root
+   directory, so chdir() and mkdir() always fail, and no file
+   descriptor refers to a directory. */
+static uint32_t sys_chdir(const uint32_t args[]) {
+  char *name = copy_in_string((const char *)args[0]);
+
+  if (name != NULL) palloc_free_page(name);
+  return false;
+}
+
+static uint32_t sys_mkdir(const uint32_t args[]) { return sys_chdir(args); }
+
+static uint32_t sys_readdir(const uint32_t args[]) {
+  if (!is_user_range((void *)args[1], NAME_MAX + 1)) kill();
+  return false;
+}
+
+static uint32_t sys_isdir(const uint32_t args[] UNUSED) { return false; }
+
+static uint32_t sys_inumber(const uint32_t args[]) {
+  struct file *file = process_file_get(args[0]);
+
+  return file != NULL ? inode_get_inumber(file_get_inode(file)) : (uint32_t)-1;
+}
+
+static uint32_t sys_fork(const uint32_t args[] UNUSED) { return process_fork(thread_current()->syscall_frame); }
+
+static uint32_t sys_threadstats(const uint32_t args[] UNUSED) {
+  thread_print_table();
+  return 0;
+}
+
+/** Layout of struct iostat in lib/user/syscall.h. */
+struct iostat {
+  int64_t now_ns;
+  uint64_t read_cnt;
+  uint64_t write_cnt;
+};
+
+/** Stores the time and the file system device's sector counts,
+   for benchmarks that measure throughput and I/O amplification. */
+static uint32_t sys_iostat(const uint32_t args[]) {
+  struct iostat st;
+  unsigned long long read_cnt, write_cnt;
+
+  block_get_stats(block_get_role(BLOCK_FILESYS), &read_cnt, &write_cnt);
+  st.read_cnt = read_cnt;
+  st.write_cnt = write_cnt;
+  st.now_ns = timer_now_ns();
+  copy_out((void *)args[0], &st, sizeof st);
+  return 0;
+}
+
+/** Creates a pipe and stores its read and write file descriptors
+   in the two ints at user address args[0]. */
+static uint32_t sys_pipe(const uint32_t args[]) {
+  int *ufds = (int *)args[0];
+  struct pipe *pipe;
+  bool writer;
+  int fds[2];
+
+  if (!is_user_range(ufds, sizeof fds)) kill();
+  pipe = pipe_create();
+  if (pipe == NULL) return false;
+
+  fds[0] = process_pipe_add(pipe, false);
+  if (fds[0] == -1) {
+    pipe_close(pipe, false);
+    pipe_close(pipe, true);
+    return false;
+  }
+  fds[1] = process_pipe_add(pipe, true);
+  if (fds[1] == -1) {
+    pipe_close(process_pipe_remove(fds[0], &writer), false);
+    pipe_close(pipe, true);
+    return false;
+  }
+  copy_out(ufds, fds, sizeof fds);
+  return true;
+}
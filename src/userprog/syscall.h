@@ -1,6 +1,18 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "threads/synch.h"
+
+/** Serializes all access to the file system, which is not yet
+   safe to use from several threads at once.  Never held while
+   touching user memory, which may fault and read a file in. */
+extern struct lock filesys_lock;
+
 void syscall_init(void);
+bool syscall_copy_in(void *dst, const void *usrc, size_t size);
+bool syscall_copy_out(void *udst, const void *src, size_t size);
 
 #endif /**< userprog/syscall.h */
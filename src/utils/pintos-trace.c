@@ -0,0 +1,187 @@
+/* Converts a kernel event trace, as dumped to the scratch device
+   by a kernel built with "make TRACE=1" and run with -trace, into
+   Chrome trace JSON, for chrome://tracing or Perfetto.
+
+   The dump format is defined in threads/trace.c. */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR_SIZE 512
+#define TRACE_MAGIC 0x43525450
+#define TRACE_VERSION 1
+#define EVENT_SIZE 16
+#define NAME_SIZE 20
+
+/* Event types, as in enum trace_type in threads/trace.h. */
+enum {
+  TRACE_SWITCH = 1,
+  TRACE_BLOCK,
+  TRACE_UNBLOCK,
+  TRACE_LOCK_WAIT,
+  TRACE_LOCK_ACQUIRE,
+  TRACE_PAGE_FAULT,
+  TRACE_READ_BEGIN,
+  TRACE_READ_END,
+  TRACE_WRITE_BEGIN,
+  TRACE_WRITE_END,
+};
+
+static uint32_t get32(const unsigned char *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint64_t get64(const unsigned char *p) { return get32(p) | (uint64_t)get32(p + 4) << 32; }
+
+/* Reads all of FILE into memory.  Returns the data and stores its
+   size in *SIZE, or exits on failure. */
+static unsigned char *read_file(const char *file, size_t *size) {
+  unsigned char *data = NULL;
+  size_t cap = 0, n;
+  FILE *f = fopen(file, "rb");
+
+  if (f == NULL) {
+    fprintf(stderr, "pintos-trace: %s: %s\n", file, strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+  *size = 0;
+  do {
+    if (*size == cap) {
+      cap = cap ? cap * 2 : 1 << 20;
+      data = realloc(data, cap);
+      if (data == NULL) {
+        fprintf(stderr, "pintos-trace: out of memory\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    n = fread(data + *size, 1, cap - *size, f);
+    *size += n;
+  } while (n > 0);
+  fclose(f);
+  return data;
+}
+
+/* Prints one JSON event, with a comma before every event but the
+   first. */
+static void event(const char *ph, const char *cat, const char *name, unsigned tid, double ts, const char *args) {
+  static bool first = true;
+
+  printf("%s\n{\"ph\":\"%s\",\"cat\":\"%s\",\"name\":\"%s\",\"pid\":0,\"tid\":%u,\"ts\":%.3f", first ? "" : ",", ph, cat, name, tid, ts);
+  if (ph[0] == 'b' || ph[0] == 'e') printf(",\"id\":%u", tid);
+  if (ph[0] == 'i') printf(",\"s\":\"t\"");
+  if (args != NULL) printf(",\"args\":{%s}", args);
+  printf("}");
+  first = false;
+}
+
+int main(int argc, char *argv[]) {
+  static bool running[65536];
+  const unsigned char *h, *names, *ev;
+  unsigned char *data;
+  size_t size, ofs, sectors;
+  uint32_t event_cnt, lost_cnt, name_cnt, i;
+  uint64_t tsc_hz, tsc0;
+  double ts = 0.0;
+  char args[64];
+
+  if (argc != 2) {
+    fprintf(stderr,
+            "pintos-trace: converts a Pintos kernel trace to Chrome trace JSON\n"
+            "usage: %s DISK > trace.json\n"
+            "  where DISK is the scratch disk, or a disk containing the\n"
+            "    scratch partition, that the kernel dumped its trace to.\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  /* Find the header, which starts a sector. */
+  data = read_file(argv[1], &size);
+  for (ofs = 0; ofs + SECTOR_SIZE <= size; ofs += SECTOR_SIZE)
+    if (get32(data + ofs) == TRACE_MAGIC && get32(data + ofs + 4) == TRACE_VERSION && get32(data + ofs + 8) == EVENT_SIZE) break;
+  if (ofs + SECTOR_SIZE > size) {
+    fprintf(stderr, "pintos-trace: %s: no trace found\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  h = data + ofs;
+  event_cnt = get32(h + 12);
+  lost_cnt = get32(h + 16);
+  name_cnt = get32(h + 20);
+  tsc_hz = get64(h + 24);
+  names = h + SECTOR_SIZE;
+  sectors = (name_cnt * NAME_SIZE + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  ev = names + sectors * SECTOR_SIZE;
+  if ((size_t)(ev - data) + (size_t)event_cnt * EVENT_SIZE > size) {
+    fprintf(stderr, "pintos-trace: %s: trace is truncated\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  if (tsc_hz == 0) fprintf(stderr, "pintos-trace: TSC frequency unknown, timestamps are in cycles\n");
+  fprintf(stderr, "pintos-trace: %" PRIu32 " events, %" PRIu32 " lost\n", event_cnt, lost_cnt);
+
+  printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+  /* Thread names. */
+  for (i = 0; i < name_cnt; i++) {
+    const unsigned char *n = names + i * NAME_SIZE;
+    uint32_t tid = get32(n);
+
+    if (tid != 0) {
+      snprintf(args, sizeof args, "\"name\":\"%.16s\"", (const char *)n + 4);
+      event("M", "__metadata", "thread_name", tid, 0.0, args);
+    }
+  }
+
+  /* Events. */
+  tsc0 = event_cnt > 0 ? get64(ev) : 0;
+  for (i = 0; i < event_cnt; i++, ev += EVENT_SIZE) {
+    uint64_t tsc = get64(ev);
+    unsigned type = ev[8] | ev[9] << 8;
+    unsigned tid = ev[10] | ev[11] << 8;
+    uint32_t arg = get32(ev + 12);
+
+    ts = tsc_hz ? (double)(tsc - tsc0) * 1e6 / tsc_hz : (double)(tsc - tsc0);
+    switch (type) {
+      case TRACE_SWITCH:
+        if (running[arg & 0xffff]) event("E", "sched", "running", arg & 0xffff, ts, NULL);
+        running[arg & 0xffff] = false;
+        event("B", "sched", "running", tid, ts, NULL);
+        running[tid] = true;
+        break;
+      case TRACE_BLOCK:
+        event("i", "sched", "block", tid, ts, NULL);
+        break;
+      case TRACE_UNBLOCK:
+        snprintf(args, sizeof args, "\"tid\":%" PRIu32, arg);
+        event("i", "sched", "unblock", tid, ts, args);
+        break;
+      case TRACE_LOCK_WAIT:
+      case TRACE_LOCK_ACQUIRE:
+        snprintf(args, sizeof args, "\"lock\":\"0x%08" PRIx32 "\"", arg);
+        event(type == TRACE_LOCK_WAIT ? "b" : "e", "lock", "lock wait", tid, ts, args);
+        break;
+      case TRACE_PAGE_FAULT:
+        snprintf(args, sizeof args, "\"addr\":\"0x%08" PRIx32 "\"", arg);
+        event("i", "vm", "page fault", tid, ts, args);
+        break;
+      case TRACE_READ_BEGIN:
+      case TRACE_READ_END:
+      case TRACE_WRITE_BEGIN:
+      case TRACE_WRITE_END:
+        snprintf(args, sizeof args, "\"sector\":%" PRIu32, arg);
+        event(type == TRACE_READ_BEGIN || type == TRACE_WRITE_BEGIN ? "b" : "e", "io",
+              type == TRACE_READ_BEGIN || type == TRACE_READ_END ? "read" : "write", tid, ts, args);
+        break;
+      default:
+        fprintf(stderr, "pintos-trace: unknown event type %u\n", type);
+        break;
+    }
+  }
+
+  /* Close the slices of threads still running at the end. */
+  for (i = 0; i < sizeof running / sizeof *running; i++)
+    if (running[i]) event("E", "sched", "running", i, ts, NULL);
+
+  printf("\n]}\n");
+  free(data);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,376 @@
+#include "vm/frame.h"
+
+#include <debug.h>
+#include <stdio.h>
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/** Frame table.
+
+   There is one struct frame for every page in palloc's user
+   pool, indexed by the page's position in the pool, so finding
+   the frame for a kernel address is a subtraction.  Every user
+   page goes through frame_alloc(); when the pool is empty a
+   victim is chosen with the second-chance clock algorithm and
+   its contents are dropped (clean file and zero pages), written
+   back to their file (dirty memory mapped pages) or written to
+   swap (everything else).
+
+   Eviction normally happens in the background: once fewer than
+   `free_low' frames are free, frame_alloc() wakes the "pageout"
+   thread, which evicts in batches of up to PAGEOUT_CLUSTER
+   frames until `free_high' are free.  Each batch is given one
+   run of adjacent swap slots, so its writes go to consecutive
+   sectors.  A process only evicts synchronously if it outruns
+   the pageout thread.
+
+   A frame may be mapped by several pages: read-only file pages
+   shared through the share table, and pages of a process and its
+   fork()ed children until one of them writes to the page.  The
+   frame's `ref_cnt' counts them.
+
+   Writing back a memory mapped page takes filesys_lock, so no
+   thread may allocate a frame while holding it. */
+
+/** Most frames evicted and written out in one batch. */
+#define PAGEOUT_CLUSTER 8
+
+struct lock frame_lock;
+struct condition frame_io_done;
+
+static struct frame *frames; /**< One per user pool page. */
+static size_t frame_cnt;     /**< Number of elements in FRAMES. */
+static size_t used_cnt;      /**< Number of frames in use. */
+static size_t hand;          /**< Clock hand, index into FRAMES. */
+
+/** Free frame watermarks for the pageout thread. */
+static size_t free_low, free_high;
+static struct semaphore pageout_sema;
+static bool pageout_wanted;
+
+/** Read-only file frames that may be shared between processes,
+   keyed by (inode, ofs, read_bytes). */
+static struct hash share_table;
+
+static thread_func pageout NO_RETURN;
+static size_t evict(size_t want);
+static void frame_release(struct frame *);
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/** Initializes the frame table and starts the pageout thread.
+   Must be called after the swap device is set up. */
+void frame_init(void) {
+  size_t i;
+
+  lock_init(&frame_lock);
+  cond_init(&frame_io_done);
+  sema_init(&pageout_sema, 0);
+
+  frame_cnt = palloc_user_page_cnt();
+  frames = calloc(frame_cnt, sizeof *frames);
+  if (frames == NULL || !hash_init(&share_table, share_hash, share_less, NULL)) PANIC("frame_init: out of memory");
+  for (i = 0; i < frame_cnt; i++) list_init(&frames[i].pages);
+
+  free_low = frame_cnt / 64 + 2;
+  free_high = free_low * 2;
+
+  thread_create("pageout", PRI_DEFAULT, pageout, NULL);
+}
+
+/** Obtains a frame from the user pool, evicting another one if
+   the pool is empty.  The frame is returned pinned and with no
+   pages attached.  Returns a null pointer if nothing can be
+   evicted. */
+struct frame *frame_alloc(void) {
+  struct frame *f;
+  void *kpage;
+
+  lock_acquire(&frame_lock);
+  while ((kpage = palloc_get_page(PAL_USER)) == NULL)
+    if (evict(1) == 0) {
+      lock_release(&frame_lock);
+      return NULL;
+    }
+
+  f = &frames[palloc_user_page_idx(kpage)];
+  ASSERT(!f->in_use && list_empty(&f->pages));
+  f->kpage = kpage;
+  f->ref_cnt = 0;
+  f->in_use = true;
+  f->pinned = true;
+  f->inode = NULL;
+  used_cnt++;
+
+  if (frame_cnt - used_cnt < free_low && !pageout_wanted) {
+    pageout_wanted = true;
+    sema_up(&pageout_sema);
+  }
+  lock_release(&frame_lock);
+  return f;
+}
+
+/** Frees F, which must be pinned and have no pages attached.
+   frame_lock must be held. */
+void frame_free(struct frame *f) {
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  ASSERT(f->pinned && f->ref_cnt == 0);
+  frame_release(f);
+}
+
+/** Makes F evictable again, freeing it if no page was attached
+   to it meanwhile.  frame_lock must be held. */
+void frame_unpin(struct frame *f) {
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  ASSERT(f->pinned);
+  f->pinned = false;
+  if (f->ref_cnt == 0) frame_release(f);
+}
+
+/** Maps P onto F.  frame_lock must be held. */
+void frame_attach(struct frame *f, struct page *p) {
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  ASSERT(p->frame == NULL);
+  list_push_back(&f->pages, &p->frame_elem);
+  f->ref_cnt++;
+  p->frame = f;
+}
+
+/** Removes P from its frame, freeing the frame if nothing else
+   maps it.  The caller must already have cleared P's page table
+   entry.  frame_lock must be held. */
+void frame_detach(struct page *p) {
+  struct frame *f = p->frame;
+
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  ASSERT(f != NULL);
+  list_remove(&p->frame_elem);
+  f->ref_cnt--;
+  p->frame = NULL;
+  if (f->ref_cnt == 0 && !f->pinned) frame_release(f);
+}
+
+/** Returns the shared frame holding READ_BYTES bytes of INODE at
+   OFS, or a null pointer if no process has that page resident.
+   frame_lock must be held. */
+struct frame *frame_share_find(struct inode *inode, off_t ofs, size_t read_bytes) {
+  struct frame key;
+  struct hash_elem *e;
+
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  key.inode = inode;
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+  e = hash_find(&share_table, &key.share_elem);
+  return e != NULL ? hash_entry(e, struct frame, share_elem) : NULL;
+}
+
+/** Makes F, which holds READ_BYTES bytes of INODE at OFS, available
+   to frame_share_find().  frame_lock must be held. */
+void frame_share_insert(struct frame *f, struct inode *inode, off_t ofs, size_t read_bytes) {
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  f->inode = inode;
+  f->ofs = ofs;
+  f->read_bytes = read_bytes;
+  hash_insert(&share_table, &f->share_elem);
+}
+
+/** Returns F to the user pool. */
+static void frame_release(struct frame *f) {
+  if (f->inode != NULL) {
+    hash_delete(&share_table, &f->share_elem);
+    f->inode = NULL;
+  }
+  f->in_use = false;
+  f->pinned = false;
+  used_cnt--;
+  palloc_free_page(f->kpage);
+}
+
+/** Returns true if any page mapping F was accessed since the
+   last call, clearing the accessed bits. */
+static bool frame_accessed(struct frame *f) {
+  bool accessed = false;
+  struct list_elem *e;
+
+  for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e)) {
+    struct page *p = container_of(e, struct page, frame_elem);
+    if (pagedir_is_accessed(p->owner->pagedir, p->upage)) {
+      pagedir_set_accessed(p->owner->pagedir, p->upage, false);
+      accessed = true;
+    }
+  }
+  return accessed;
+}
+
+/** Returns true if evicting F might require writing it to swap,
+   that is, if its contents might differ from their source and
+   that source is not a memory mapped file. */
+static bool frame_may_be_dirty(struct frame *f) {
+  struct list_elem *e;
+
+  for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e)) {
+    struct page *p = container_of(e, struct page, frame_elem);
+    if (p->type == PAGE_MMAP) return false;
+    if (p->writable || p->type == PAGE_SWAP) return true;
+  }
+  return false;
+}
+
+/** Returns F's page if it is a memory mapped page, which is never
+   shared, or a null pointer. */
+static struct page *frame_mmap_page(struct frame *f) {
+  struct page *p = container_of(list_front(&f->pages), struct page, frame_elem);
+  return p->type == PAGE_MMAP ? p : NULL;
+}
+
+/** Runs the clock hand for up to two sweeps and pins up to WANT
+   frames that were not accessed since the hand last passed.
+   Stores them in VICTIM and returns how many there are. */
+static size_t choose_victims(struct frame **victim, size_t want) {
+  size_t cnt = 0;
+  size_t step;
+
+  for (step = 0; step < 2 * frame_cnt && cnt < want; step++) {
+    struct frame *f = &frames[hand];
+
+    hand = (hand + 1) % frame_cnt;
+    if (!f->in_use || f->pinned || f->ref_cnt == 0 || frame_accessed(f)) continue;
+
+    /* Nobody may start sharing a frame on its way out. */
+    if (f->inode != NULL) {
+      hash_delete(&share_table, &f->share_elem);
+      f->inode = NULL;
+    }
+    f->pinned = true;
+    victim[cnt++] = f;
+  }
+  return cnt;
+}
+
+/** Evicts up to WANT (at most PAGEOUT_CLUSTER) frames and returns
+   them to the user pool.  Returns the number of frames freed.
+   frame_lock must be held; it is released while pages are
+   written out. */
+static size_t evict(size_t want) {
+  struct frame *victim[PAGEOUT_CLUSTER];
+  size_t slot[PAGEOUT_CLUSTER];
+  bool dirty[PAGEOUT_CLUSTER];
+  bool write_back[PAGEOUT_CLUSTER];
+  size_t cnt, dirty_cnt, run, i, j;
+  struct list_elem *e;
+
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  if (want > PAGEOUT_CLUSTER) want = PAGEOUT_CLUSTER;
+  cnt = choose_victims(victim, want);
+
+  /* Reserve swap for every victim that might be dirty, as one
+     run of adjacent slots if possible.  A victim that cannot get
+     a slot stays where it is. */
+  for (i = dirty_cnt = 0; i < cnt; i++) dirty_cnt += frame_may_be_dirty(victim[i]);
+  run = dirty_cnt > 1 ? swap_alloc(dirty_cnt) : SWAP_ERROR;
+  for (i = j = 0; i < cnt; i++) {
+    struct frame *f = victim[i];
+
+    slot[j] = SWAP_ERROR;
+    if (frame_may_be_dirty(f)) {
+      slot[j] = run != SWAP_ERROR ? run++ : swap_alloc(1);
+      if (slot[j] == SWAP_ERROR) {
+        f->pinned = false;
+        continue;
+      }
+    }
+    victim[j++] = f;
+  }
+  cnt = j;
+
+  /* Unmap the victims.  Once a page table entry is cleared, the
+     dirty bit can no longer change. */
+  for (i = 0; i < cnt; i++) {
+    struct page *mp = frame_mmap_page(victim[i]);
+
+    dirty[i] = write_back[i] = false;
+    for (e = list_begin(&victim[i]->pages); e != list_end(&victim[i]->pages); e = list_next(e)) {
+      struct page *p = container_of(e, struct page, frame_elem);
+      pagedir_clear_page(p->owner->pagedir, p->upage);
+      if (mp != NULL)
+        write_back[i] = pagedir_is_dirty(p->owner->pagedir, p->upage);
+      else if (pagedir_is_dirty(p->owner->pagedir, p->upage) || p->type == PAGE_SWAP)
+        dirty[i] = true;
+      p->busy = true;
+    }
+    if (!dirty[i] && slot[i] != SWAP_ERROR) {
+      swap_free(slot[i]);
+      slot[i] = SWAP_ERROR;
+    }
+  }
+
+  lock_release(&frame_lock);
+  for (i = 0; i < cnt; i++)
+    if (dirty[i])
+      swap_write(slot[i], victim[i]->kpage);
+    else if (write_back[i]) {
+      struct page *p = frame_mmap_page(victim[i]);
+
+      lock_acquire(&filesys_lock);
+      file_write_at(p->file, victim[i]->kpage, p->read_bytes, p->ofs);
+      lock_release(&filesys_lock);
+    }
+  lock_acquire(&frame_lock);
+
+  for (i = 0; i < cnt; i++) {
+    struct frame *f = victim[i];
+    bool first = true;
+
+    /* Every page that shared the frame now shares the slot. */
+    while (!list_empty(&f->pages)) {
+      struct page *p = container_of(list_pop_front(&f->pages), struct page, frame_elem);
+      p->frame = NULL;
+      if (dirty[i]) {
+        if (!first) swap_dup(slot[i]);
+        p->type = PAGE_SWAP;
+        p->swap_slot = slot[i];
+        first = false;
+      }
+      p->busy = false;
+    }
+    f->ref_cnt = 0;
+    frame_release(f);
+  }
+  cond_broadcast(&frame_io_done, &frame_lock);
+  return cnt;
+}
+
+/** Pageout thread.  Keeps at least `free_low' frames free so
+   that page faults rarely have to wait for a swap write. */
+static void pageout(void *aux UNUSED) {
+  for (;;) {
+    sema_down(&pageout_sema);
+
+    lock_acquire(&frame_lock);
+    while (frame_cnt - used_cnt < free_high)
+      if (evict(PAGEOUT_CLUSTER) == 0) break;
+    pageout_wanted = false;
+    lock_release(&frame_lock);
+  }
+}
+
+static unsigned share_hash(const struct hash_elem *e, void *aux UNUSED) {
+  const struct frame *f = hash_entry(e, struct frame, share_elem);
+  return hash_bytes(&f->inode, sizeof f->inode) ^ hash_int(f->ofs);
+}
+
+static bool share_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED) {
+  const struct frame *a = hash_entry(a_, struct frame, share_elem);
+  const struct frame *b = hash_entry(b_, struct frame, share_elem);
+  if (a->inode != b->inode) return a->inode < b->inode;
+  if (a->ofs != b->ofs) return a->ofs < b->ofs;
+  return a->read_bytes < b->read_bytes;
+}
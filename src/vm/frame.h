@@ -0,0 +1,47 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct inode;
+struct page;
+
+/** A physical frame from the user pool. */
+struct frame {
+  void *kpage;       /**< Kernel virtual address. */
+  struct list pages; /**< struct page's mapping this frame. */
+  unsigned ref_cnt;  /**< Number of elements in PAGES. */
+  bool in_use;       /**< Handed out by frame_alloc()? */
+  bool pinned;       /**< Exempt from eviction. */
+
+  /* Read-only file frames shared between processes. */
+  struct inode *inode;         /**< Non-null while in the share table. */
+  off_t ofs;                   /**< Offset of the page in INODE. */
+  size_t read_bytes;           /**< Bytes read from INODE, rest zero. */
+  struct hash_elem share_elem; /**< Element in the share table. */
+};
+
+/** Protects the frame table, the share table, and the residency
+   fields (`frame', `type', `swap_slot', `busy') of every struct
+   page.  Page I/O is done without it, with the page marked busy;
+   waiters sleep on frame_io_done. */
+extern struct lock frame_lock;
+extern struct condition frame_io_done;
+
+void frame_init(void);
+struct frame *frame_alloc(void);
+void frame_free(struct frame *);
+void frame_unpin(struct frame *);
+void frame_attach(struct frame *, struct page *);
+void frame_detach(struct page *);
+
+struct frame *frame_share_find(struct inode *, off_t ofs, size_t read_bytes);
+void frame_share_insert(struct frame *, struct inode *, off_t ofs, size_t read_bytes);
+
+#endif /**< vm/frame.h */
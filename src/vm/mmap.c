@@ -0,0 +1,241 @@
+#include "vm/mmap.h"
+
+#include <debug.h>
+#include <rbtree.h>
+#include <round.h>
+#include <stdint.h>
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/** Memory mapped files.
+
+   A mapping is a run of PAGE_MMAP pages in the supplemental page
+   table.  They are read in on demand like executable pages, but
+   are written back to the file when they are evicted dirty and
+   when the mapping goes away.  Mappings are not inherited by
+   fork().
+
+   Each thread keeps its mappings in a red-black tree ordered by
+   address and augmented with the end of the last page mapped in
+   each subtree, making it an interval tree in which an overlap
+   with a new mapping is found in O(lg n).  A second tree holds
+   the same mappings by identifier for munmap().
+
+   Below the stack's reserved space, the only other pages are the
+   executable's, so the thread also records the range of pages
+   they span and mappings may not fall anywhere inside it, not
+   even in a gap between segments.  With that, the trees are the
+   authority for what is mapped, and checking that a new mapping
+   is free costs O(lg n) whatever its length. */
+
+/** A memory mapped file. */
+struct mapping {
+  int id;                 /**< Mapping identifier. */
+  struct file *file;      /**< Private reopened file. */
+  uint8_t *addr;          /**< First mapped page. */
+  size_t page_cnt;        /**< Number of mapped pages. */
+  struct rb_node node;    /**< Node in thread's `mappings'. */
+  struct rb_node id_node; /**< Node in thread's `mapids'. */
+  uintptr_t max_end;      /**< Greatest mapping end in this subtree. */
+};
+
+static bool range_is_free(uint8_t *addr, size_t page_cnt);
+static bool mapping_overlaps(uintptr_t start, uintptr_t end);
+static struct mapping *mapping_lookup(int mapid);
+static void mapping_destroy(struct mapping *);
+static rb_less_func mapping_less;
+static rb_less_func mapping_id_less;
+static rb_update_func mapping_update;
+
+/** Initializes T's empty set of mappings and executable range. */
+void mmap_table_init(struct thread *t) {
+  rb_init(&t->mappings, mapping_less, mapping_update, NULL);
+  rb_init(&t->mapids, mapping_id_less, NULL, NULL);
+  t->image_start = t->image_end = 0;
+}
+
+/** Records that PAGE_CNT pages starting at UPAGE belong to the
+   current process's executable, so that no mapping may overlap
+   them. */
+void mmap_reserve(void *upage, size_t page_cnt) {
+  struct thread *t = thread_current();
+  uintptr_t start = (uintptr_t)upage;
+  uintptr_t end = start + page_cnt * PGSIZE;
+
+  if (t->image_start == t->image_end) {
+    t->image_start = start;
+    t->image_end = end;
+  } else {
+    if (start < t->image_start) t->image_start = start;
+    if (end > t->image_end) t->image_end = end;
+  }
+}
+
+/** Gives the current process the same executable range as
+   PARENT, whose pages it has copied.  Mappings themselves are not
+   inherited. */
+void mmap_fork(const struct thread *parent) {
+  struct thread *t = thread_current();
+
+  t->image_start = parent->image_start;
+  t->image_end = parent->image_end;
+}
+
+/** Maps FILE into the current process starting at ADDR.  Returns
+   the mapping's identifier, or -1 if ADDR is null or not page
+   aligned, if FILE is empty, or if any page of the mapping would
+   overlap the executable, another mapping or the stack. */
+int mmap_map(struct file *file, void *addr) {
+  struct thread *t = thread_current();
+  struct mapping *m;
+  off_t length;
+  size_t i;
+
+  if (addr == NULL || pg_ofs(addr) != 0) return -1;
+
+  m = malloc(sizeof *m);
+  if (m == NULL) return -1;
+  lock_acquire(&filesys_lock);
+  length = file_length(file);
+  m->file = length > 0 ? file_reopen(file) : NULL;
+  lock_release(&filesys_lock);
+  if (m->file == NULL) {
+    free(m);
+    return -1;
+  }
+  m->addr = addr;
+  m->page_cnt = DIV_ROUND_UP(length, PGSIZE);
+
+  if (!range_is_free(m->addr, m->page_cnt)) {
+    m->page_cnt = 0;
+    mapping_destroy(m);
+    return -1;
+  }
+
+  for (i = 0; i < m->page_cnt; i++) {
+    off_t ofs = i * PGSIZE;
+    size_t read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+
+    if (!page_add_mmap(m->addr + i * PGSIZE, m->file, ofs, read_bytes)) {
+      m->page_cnt = i;
+      mapping_destroy(m);
+      return -1;
+    }
+  }
+
+  m->id = t->next_mapid++;
+  rb_insert(&t->mappings, &m->node);
+  rb_insert(&t->mapids, &m->id_node);
+  return m->id;
+}
+
+/** Unmaps mapping MAPID of the current process, writing back
+   every page that was modified.  Does nothing if there is no such
+   mapping. */
+void mmap_unmap(int mapid) {
+  struct mapping *m = mapping_lookup(mapid);
+
+  if (m != NULL) {
+    rb_remove(&thread_current()->mappings, &m->node);
+    rb_remove(&thread_current()->mapids, &m->id_node);
+    mapping_destroy(m);
+  }
+}
+
+/** Unmaps all of the current process's mappings. */
+void mmap_unmap_all(void) {
+  struct thread *t = thread_current();
+
+  while (!rb_empty(&t->mappings)) {
+    struct mapping *m = rb_entry(t->mappings.root, struct mapping, node);
+
+    rb_remove(&t->mappings, &m->node);
+    rb_remove(&t->mapids, &m->id_node);
+    mapping_destroy(m);
+  }
+}
+
+/** Returns true if PAGE_CNT pages starting at ADDR lie below the
+   space the stack may grow into and overlap neither the current
+   process's executable nor any of its mappings. */
+static bool range_is_free(uint8_t *addr, size_t page_cnt) {
+  struct thread *t = thread_current();
+  uintptr_t stack_bottom = (uintptr_t)PHYS_BASE - stack_limit;
+  uintptr_t start = (uintptr_t)addr;
+  uintptr_t end;
+
+  if (start >= stack_bottom || page_cnt > (stack_bottom - start) / PGSIZE) return false;
+  end = start + page_cnt * PGSIZE;
+  if (start < t->image_end && t->image_start < end) return false;
+  return !mapping_overlaps(start, end);
+}
+
+/** Returns true if any of the current process's mappings
+   overlaps the addresses [START, END). */
+static bool mapping_overlaps(uintptr_t start, uintptr_t end) {
+  struct rb_node *n = thread_current()->mappings.root;
+
+  /* If the left subtree reaches past START, then either it holds
+     an overlapping mapping or nothing to the right can overlap
+     either, since those mappings all begin later. */
+  while (n != NULL) {
+    struct mapping *m = rb_entry(n, struct mapping, node);
+
+    if ((uintptr_t)m->addr < end && start < (uintptr_t)m->addr + m->page_cnt * PGSIZE) return true;
+    if (n->left != NULL && rb_entry(n->left, struct mapping, node)->max_end > start)
+      n = n->left;
+    else
+      n = n->right;
+  }
+  return false;
+}
+
+/** Returns the current process's mapping MAPID, or a null pointer
+   if there is none. */
+static struct mapping *mapping_lookup(int mapid) {
+  struct mapping key;
+  struct rb_node *n;
+
+  key.id = mapid;
+  n = rb_find(&thread_current()->mapids, &key.id_node);
+  return n != NULL ? rb_entry(n, struct mapping, id_node) : NULL;
+}
+
+/** Removes M's pages, closes its file and frees it.  M must not be
+   in a tree. */
+static void mapping_destroy(struct mapping *m) {
+  size_t i;
+
+  pagedir_batch_begin();
+  for (i = 0; i < m->page_cnt; i++) page_remove(m->addr + i * PGSIZE);
+  pagedir_batch_end();
+  lock_acquire(&filesys_lock);
+  file_close(m->file);
+  lock_release(&filesys_lock);
+  free(m);
+}
+
+/** Orders mappings by address. */
+static bool mapping_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct mapping, node)->addr < rb_entry(b, struct mapping, node)->addr;
+}
+
+/** Orders mappings by identifier. */
+static bool mapping_id_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct mapping, id_node)->id < rb_entry(b, struct mapping, id_node)->id;
+}
+
+/** Recomputes the greatest mapping end in N's subtree. */
+static void mapping_update(struct rb_node *n, void *aux UNUSED) {
+  struct mapping *m = rb_entry(n, struct mapping, node);
+
+  m->max_end = (uintptr_t)m->addr + m->page_cnt * PGSIZE;
+  if (n->left != NULL && rb_entry(n->left, struct mapping, node)->max_end > m->max_end) m->max_end = rb_entry(n->left, struct mapping, node)->max_end;
+  if (n->right != NULL && rb_entry(n->right, struct mapping, node)->max_end > m->max_end) m->max_end = rb_entry(n->right, struct mapping, node)->max_end;
+}
@@ -0,0 +1,16 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <stddef.h>
+
+struct file;
+struct thread;
+
+void mmap_table_init(struct thread *);
+void mmap_reserve(void *upage, size_t page_cnt);
+void mmap_fork(const struct thread *parent);
+int mmap_map(struct file *, void *addr);
+void mmap_unmap(int mapid);
+void mmap_unmap_all(void);
+
+#endif /**< vm/mmap.h */
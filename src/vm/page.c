@@ -0,0 +1,456 @@
+#include "vm/page.h"
+
+#include <debug.h>
+#include <hash.h>
+#include <string.h>
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/** Demand paging.
+
+   load() no longer reads executables into memory.  It records,
+   for every page of every PT_LOAD segment, where that page's
+   contents live (see struct page), and the page is read in by
+   page_fault() the first time the process touches it.  Pages the
+   process never touches are never read.
+
+   Read-only file pages, which in practice are the text and
+   rodata of executables, are additionally shared between every
+   process that maps the same part of the same inode, through the
+   frame table's share table.
+
+   fork() copies the page table without copying any memory: the
+   child maps the parent's frames, and writable ones are made
+   read-only in both processes.  The first write by either one
+   faults into page_unshare(), which gives the writer a copy of
+   its own (or just makes the page writable again if nobody else
+   maps the frame any more).
+
+   Only the top page of the stack is set up by load().  The rest
+   is added by page_grow_stack() when the process faults on it, up
+   to `stack_limit' bytes below PHYS_BASE.  Below that limit lies
+   an unmapped guard region, so runaway recursion faults instead
+   of growing into the heap or data segment. */
+
+/** The 80x86 PUSHA instruction checks permissions before moving
+   the stack pointer, so it may fault this many bytes below ESP. */
+#define PUSHA_SLOP 32
+
+size_t stack_limit = STACK_LIMIT_DEFAULT;
+
+static rhash_hash_func page_hash;
+static rhash_less_func page_less;
+static rhash_action_func page_destructor;
+
+static bool page_add(void *upage, enum page_type, struct file *, off_t ofs, size_t read_bytes, bool writable);
+static bool page_insert(struct page *);
+static struct frame *page_fill(struct page *);
+
+/** Initializes PAGES as an empty supplemental page table.
+   Returns false if memory allocation fails. */
+bool page_table_init(struct rhash *pages) { return rhash_init(pages, page_hash, page_less, NULL); }
+
+/** Destroys the current thread's supplemental page table PAGES,
+   unmapping and releasing every page.  Must be called before the
+   thread's page directory is destroyed. */
+void page_table_destroy(struct rhash *pages) {
+  pagedir_batch_begin();
+  lock_acquire(&frame_lock);
+  rhash_destroy(pages, page_destructor);
+  lock_release(&frame_lock);
+  pagedir_batch_end();
+}
+
+/** Returns the current thread's page table entry for the page
+   containing UPAGE, or a null pointer if there is none.  PAGES may
+   be uninitialized, as it is in a kernel thread. */
+struct page *page_lookup(struct rhash *pages, const void *upage) {
+  struct page p;
+  struct rhash_elem *e;
+
+  if (!rhash_initialized(pages)) return NULL;
+
+  p.upage = pg_round_down(upage);
+  e = rhash_find(pages, &p.elem);
+  return e != NULL ? rhash_entry(e, struct page, elem) : NULL;
+}
+
+/** Records that UPAGE in the current process is backed by
+   READ_BYTES bytes of FILE starting at OFS, followed by
+   PGSIZE - READ_BYTES zero bytes.  Nothing is read until the page
+   is first accessed.  FILE must stay open for as long as the
+   mapping exists.  Returns false if UPAGE is already recorded or
+   if memory allocation fails. */
+bool page_add_file(void *upage, struct file *file, off_t ofs, size_t read_bytes, bool writable) {
+  return page_add(upage, read_bytes > 0 ? PAGE_FILE : PAGE_ZERO, file, ofs, read_bytes, writable);
+}
+
+/** Records that UPAGE in the current process is an all-zero
+   page.  Returns false if UPAGE is already recorded or if memory
+   allocation fails. */
+bool page_add_zero(void *upage, bool writable) { return page_add_file(upage, NULL, 0, 0, writable); }
+
+/** Records that UPAGE in the current process is a writable
+   mapping of READ_BYTES bytes of FILE starting at OFS, followed by
+   zeros.  Unlike with page_add_file(), changes to the page are
+   written back to FILE.  Returns false if UPAGE is already
+   recorded or if memory allocation fails. */
+bool page_add_mmap(void *upage, struct file *file, off_t ofs, size_t read_bytes) { return page_add(upage, PAGE_MMAP, file, ofs, read_bytes, true); }
+
+/** Records UPAGE with TYPE in the current process's page table. */
+static bool page_add(void *upage, enum page_type type, struct file *file, off_t ofs, size_t read_bytes, bool writable) {
+  struct page *p;
+
+  ASSERT(pg_ofs(upage) == 0);
+  ASSERT(read_bytes <= PGSIZE);
+
+  p = malloc(sizeof *p);
+  if (p == NULL) return false;
+
+  p->upage = upage;
+  p->owner = thread_current();
+  p->writable = writable;
+  p->frame = NULL;
+  p->type = type;
+  p->swap_slot = SWAP_ERROR;
+  p->busy = false;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  return page_insert(p);
+}
+
+/** Removes the page containing UPAGE from the current process.
+   A dirty PAGE_MMAP page is first written back to its file. */
+void page_remove(void *upage) {
+  struct thread *t = thread_current();
+  struct page *p = page_lookup(&t->pages, upage);
+  struct frame *f;
+
+  if (p == NULL) return;
+
+  lock_acquire(&frame_lock);
+  while (p->busy) cond_wait(&frame_io_done, &frame_lock);
+  rhash_delete(&t->pages, &p->elem);
+  f = p->frame;
+  if (f != NULL && p->type == PAGE_MMAP && pagedir_is_dirty(t->pagedir, p->upage)) {
+    /* Keep the frame while it is written out. */
+    pagedir_clear_page(t->pagedir, p->upage);
+    f->pinned = true;
+    frame_detach(p);
+    lock_release(&frame_lock);
+
+    lock_acquire(&filesys_lock);
+    file_write_at(p->file, f->kpage, p->read_bytes, p->ofs);
+    lock_release(&filesys_lock);
+
+    lock_acquire(&frame_lock);
+    frame_unpin(f);
+    lock_release(&frame_lock);
+    free(p);
+  } else {
+    page_destructor(&p->elem, NULL);
+    lock_release(&frame_lock);
+  }
+}
+
+/** Returns true if P's frame may be shared with other processes
+   that map the same file page. */
+static bool page_is_shareable(const struct page *p) { return p->type == PAGE_FILE && !p->writable; }
+
+/** Brings the page containing UPAGE into memory for the current
+   process and maps it.  Returns false if UPAGE is not part of
+   the process's address space or if no frame is available. */
+bool page_load(void *upage) {
+  struct thread *t = thread_current();
+  struct page *p = page_lookup(&t->pages, upage);
+  struct frame *f, *shared;
+  bool success = true;
+
+  if (p == NULL) return false;
+
+  lock_acquire(&frame_lock);
+  while (p->busy) cond_wait(&frame_io_done, &frame_lock);
+  if (p->frame == NULL) {
+    p->busy = true;
+    f = page_is_shareable(p) ? frame_share_find(file_get_inode(p->file), p->ofs, p->read_bytes) : NULL;
+    if (f == NULL) {
+      lock_release(&frame_lock);
+      f = page_fill(p);
+      lock_acquire(&frame_lock);
+
+      if (f != NULL) {
+        /* Another process may have read the same shared page in
+           while we were reading ours. */
+        if (page_is_shareable(p)) {
+          shared = frame_share_find(file_get_inode(p->file), p->ofs, p->read_bytes);
+          if (shared != NULL) {
+            frame_free(f);
+            f = shared;
+          } else
+            frame_share_insert(f, file_get_inode(p->file), p->ofs, p->read_bytes);
+        }
+        f->pinned = false;
+      }
+    }
+
+    if (f != NULL && pagedir_set_page(t->pagedir, p->upage, f->kpage, p->writable))
+      frame_attach(f, p);
+    else {
+      if (f != NULL && f->ref_cnt == 0) {
+        f->pinned = true;
+        frame_free(f);
+      }
+      success = false;
+    }
+    p->busy = false;
+    cond_broadcast(&frame_io_done, &frame_lock);
+  }
+  lock_release(&frame_lock);
+  return success;
+}
+
+/** Adds a zeroed stack page for a fault at ADDR by a process
+   whose stack pointer is ESP, and brings it in.  Returns false if
+   ADDR does not look like a stack access: if it is below ESP by
+   more than PUSH and PUSHA can reach, or outside the stack limit. */
+bool page_grow_stack(void *addr, const void *esp) {
+  uint8_t *stack_bottom = (uint8_t *)PHYS_BASE - stack_limit;
+  void *upage = pg_round_down(addr);
+
+  if ((uint8_t *)addr < stack_bottom || (uint8_t *)addr + PUSHA_SLOP < (uint8_t *)esp) return false;
+
+  /* The page is already recorded if an earlier attempt to bring
+     it in ran out of frames. */
+  if (page_lookup(&thread_current()->pages, upage) == NULL && !page_add_zero(upage, true)) return false;
+  return page_load(upage);
+}
+
+/** Handles a write to the page containing UPAGE, which is
+   mapped read-only because its frame is shared with a fork()ed
+   process.  Returns false if the page is not writable or if no
+   frame is available for the copy. */
+bool page_unshare(void *upage) {
+  struct thread *t = thread_current();
+  struct page *p = page_lookup(&t->pages, upage);
+  struct frame *old, *copy = NULL;
+  bool success;
+
+  if (p == NULL || !p->writable) return false;
+
+  lock_acquire(&frame_lock);
+  for (;;) {
+    while (p->busy) cond_wait(&frame_io_done, &frame_lock);
+    old = p->frame;
+    if (old == NULL || old->ref_cnt == 1 || copy != NULL) break;
+
+    /* frame_alloc() takes frame_lock itself, and the page may be
+       evicted or the other mappings may go away meanwhile, so
+       look again afterward. */
+    lock_release(&frame_lock);
+    copy = frame_alloc();
+    lock_acquire(&frame_lock);
+    if (copy == NULL) break;
+  }
+
+  if (old == NULL) {
+    /* Evicted: reading it back in gives us a private frame. */
+    if (copy != NULL) frame_free(copy);
+    lock_release(&frame_lock);
+    return page_load(upage);
+  }
+
+  if (old->ref_cnt == 1) {
+    pagedir_set_writable(t->pagedir, p->upage, true);
+    if (copy != NULL) frame_free(copy);
+    success = true;
+  } else if (copy != NULL) {
+    /* Our mapping has been read-only since the fork, so it cannot
+       be dirty: the contents' source is already recorded in
+       `type'. */
+    memcpy(copy->kpage, old->kpage, PGSIZE);
+    pagedir_clear_page(t->pagedir, p->upage);
+    frame_detach(p);
+    success = pagedir_set_page(t->pagedir, p->upage, copy->kpage, true);
+    ASSERT(success);
+    frame_attach(copy, p);
+    frame_unpin(copy);
+  } else
+    success = false;
+  lock_release(&frame_lock);
+  return success;
+}
+
+/** Maps *F, a pinned frame that no page maps, at UPAGE in the
+   current process in place of the frame there, and stores that
+   frame, pinned and no longer mapped, in *F.  The page's contents
+   become those of the frame given, which from now on belong in
+   swap when evicted.  Returns false, changing nothing, unless
+   UPAGE is a resident, writable page that is not memory mapped
+   and whose frame no other page shares. */
+bool page_flip(void *upage, struct frame **f) {
+  struct thread *t = thread_current();
+  struct page *p = page_lookup(&t->pages, upage);
+  struct frame *old;
+  bool success = false;
+
+  if (p == NULL || !p->writable || p->type == PAGE_MMAP) return false;
+
+  lock_acquire(&frame_lock);
+  while (p->busy) cond_wait(&frame_io_done, &frame_lock);
+  old = p->frame;
+  if (old != NULL && old->ref_cnt == 1 && !old->pinned) {
+    pagedir_clear_page(t->pagedir, p->upage);
+    old->pinned = true;
+    frame_detach(p);
+    success = pagedir_set_page(t->pagedir, p->upage, (*f)->kpage, true);
+    ASSERT(success);
+    frame_attach(*f, p);
+    (*f)->pinned = false;
+    p->type = PAGE_SWAP;
+    *f = old;
+  }
+  lock_release(&frame_lock);
+  return success;
+}
+
+/** Makes the current thread's page table a copy-on-write copy of
+   PARENT's, mapping every page resident in PARENT to the same
+   frame.  The current thread's page directory and page table must
+   be initialized and empty, and PARENT must not run meanwhile.
+   Returns false if memory allocation fails, in which case the
+   pages copied so far must still be destroyed. */
+bool page_table_copy(struct thread *parent) {
+  struct thread *t = thread_current();
+  struct rhash_iterator i;
+  bool success = true;
+
+  lock_acquire(&frame_lock);
+  rhash_first(&i, &parent->pages);
+  while (success && rhash_next(&i)) {
+    struct page *p = rhash_entry(rhash_cur(&i), struct page, elem);
+    struct page *c;
+
+    /* Memory mappings are not inherited. */
+    if (p->type == PAGE_MMAP) continue;
+
+    c = malloc(sizeof *c);
+    if (c == NULL) {
+      success = false;
+      break;
+    }
+    while (p->busy) cond_wait(&frame_io_done, &frame_lock);
+
+    c->upage = p->upage;
+    c->owner = t;
+    c->writable = p->writable;
+    c->frame = NULL;
+    c->swap_slot = p->swap_slot;
+    c->busy = false;
+    c->file = p->file == parent->exec_file ? t->exec_file : p->file;
+    c->ofs = p->ofs;
+    c->read_bytes = p->read_bytes;
+    if (!page_insert(c)) {
+      success = false;
+      break;
+    }
+
+    if (p->frame != NULL) {
+      if (p->writable) {
+        /* From now on neither process may write to the frame
+           without faulting, so the dirty bit has to be folded
+           into the type here. */
+        if (pagedir_is_dirty(parent->pagedir, p->upage)) p->type = PAGE_SWAP;
+        pagedir_set_writable(parent->pagedir, p->upage, false);
+      }
+      c->type = p->type;
+      if (pagedir_set_page(t->pagedir, c->upage, p->frame->kpage, false))
+        frame_attach(p->frame, c);
+      else
+        success = false;
+    } else {
+      c->type = p->type;
+      if (c->type == PAGE_SWAP) swap_dup(c->swap_slot);
+    }
+  }
+  lock_release(&frame_lock);
+  return success;
+}
+
+/** Obtains a frame and fills it with the contents of P, which
+   must be marked busy.  Returns the pinned frame, or a null
+   pointer on failure. */
+static struct frame *page_fill(struct page *p) {
+  struct frame *f = frame_alloc();
+  bool ok;
+
+  if (f == NULL) return NULL;
+
+  switch (p->type) {
+    case PAGE_ZERO:
+      memset(f->kpage, 0, PGSIZE);
+      break;
+    case PAGE_FILE:
+    case PAGE_MMAP:
+      lock_acquire(&filesys_lock);
+      ok = file_read_at(p->file, f->kpage, p->read_bytes, p->ofs) == (off_t)p->read_bytes;
+      lock_release(&filesys_lock);
+      if (!ok) {
+        lock_acquire(&frame_lock);
+        frame_free(f);
+        lock_release(&frame_lock);
+        return NULL;
+      }
+      memset((uint8_t *)f->kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+      break;
+    case PAGE_SWAP:
+      /* From now on the only copy is in memory. */
+      swap_read(p->swap_slot, f->kpage);
+      swap_free(p->swap_slot);
+      p->swap_slot = SWAP_ERROR;
+      break;
+  }
+  return f;
+}
+
+/** Adds P to the current thread's page table, freeing it and
+   returning false if its page is already there. */
+static bool page_insert(struct page *p) {
+  if (rhash_insert(&thread_current()->pages, &p->elem) != NULL) {
+    free(p);
+    return false;
+  }
+  return true;
+}
+
+/** Unmaps and frees page table entry E.  frame_lock must be
+   held. */
+static void page_destructor(struct rhash_elem *e, void *aux UNUSED) {
+  struct page *p = rhash_entry(e, struct page, elem);
+
+  while (p->busy) cond_wait(&frame_io_done, &frame_lock);
+  if (p->frame != NULL) {
+    pagedir_clear_page(p->owner->pagedir, p->upage);
+    frame_detach(p);
+  } else if (p->type == PAGE_SWAP && p->swap_slot != SWAP_ERROR)
+    swap_free(p->swap_slot);
+  free(p);
+}
+
+static unsigned page_hash(const struct rhash_elem *e, void *aux UNUSED) {
+  const struct page *p = rhash_entry(e, struct page, elem);
+  return hash_int(pg_no(p->upage));
+}
+
+static bool page_less(const struct rhash_elem *a_, const struct rhash_elem *b_, void *aux UNUSED) {
+  const struct page *a = rhash_entry(a_, struct page, elem);
+  const struct page *b = rhash_entry(b_, struct page, elem);
+  return a->upage < b->upage;
+}
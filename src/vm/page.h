@@ -0,0 +1,68 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <list.h>
+#include <rhash.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "filesys/off_t.h"
+
+struct file;
+struct frame;
+struct thread;
+
+/** Where the contents of a non-resident page are. */
+enum page_type {
+  PAGE_ZERO, /**< All zeros. */
+  PAGE_FILE, /**< READ_BYTES from FILE at OFS, then zeros. */
+  PAGE_SWAP, /**< In SWAP_SLOT, or only in memory while resident. */
+  PAGE_MMAP, /**< Like PAGE_FILE, but written back when dirty. */
+};
+
+/** Supplemental page table entry.
+
+   Every user virtual page that a process may legally touch has
+   one of these in its thread's `pages' table, whether or not a
+   frame currently backs it.  The hardware page table only knows
+   about resident pages; this is where page_fault() finds out how
+   to bring in the rest. */
+struct page {
+  void *upage;          /**< User virtual address, page aligned. */
+  struct thread *owner; /**< Process whose address space this is. */
+  bool writable;        /**< May the process write to it? */
+
+  /* Protected by frame_lock. */
+  struct frame *frame;         /**< Backing frame, or NULL if not resident. */
+  enum page_type type;         /**< Where the contents are when not resident. */
+  size_t swap_slot;            /**< PAGE_SWAP: slot, if not resident. */
+  bool busy;                   /**< Being read in or written out. */
+  struct list_elem frame_elem; /**< Element in frame's `pages'. */
+
+  struct file *file;      /**< PAGE_FILE, PAGE_MMAP: file to read from. */
+  off_t ofs;              /**< PAGE_FILE, PAGE_MMAP: offset of page in FILE. */
+  size_t read_bytes;      /**< PAGE_FILE, PAGE_MMAP: bytes to read, rest is zeroed. */
+  struct rhash_elem elem; /**< Element in thread's `pages'. */
+};
+
+/** Default for stack_limit: 8 MB, as on most Unix systems. */
+#define STACK_LIMIT_DEFAULT (8 * 1024 * 1024)
+
+/** Most bytes the user stack may grow to. */
+extern size_t stack_limit;
+
+bool page_table_init(struct rhash *pages);
+void page_table_destroy(struct rhash *pages);
+bool page_table_copy(struct thread *parent);
+
+struct page *page_lookup(struct rhash *pages, const void *upage);
+bool page_add_file(void *upage, struct file *file, off_t ofs, size_t read_bytes, bool writable);
+bool page_add_zero(void *upage, bool writable);
+bool page_add_mmap(void *upage, struct file *file, off_t ofs, size_t read_bytes);
+void page_remove(void *upage);
+bool page_load(void *upage);
+bool page_unshare(void *upage);
+bool page_flip(void *upage, struct frame **);
+bool page_grow_stack(void *addr, const void *esp);
+
+#endif /**< vm/page.h */
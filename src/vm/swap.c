@@ -0,0 +1,91 @@
+#include "vm/swap.h"
+
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/** Swap space.
+
+   The BLOCK_SWAP device is divided into page-sized slots of
+   SECTORS_PER_PAGE consecutive sectors each.  `swap_map' has one
+   bit per slot, set while the slot holds a page.  Evicted pages
+   are written out in batches, and swap_alloc() hands each batch
+   a run of adjacent slots so that the writes land on consecutive
+   sectors.
+
+   A slot can back more than one page after fork(), so each slot
+   also has a reference count in `slot_refs'. */
+
+#define SECTORS_PER_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block *swap_block;
+static struct bitmap *swap_map;
+static uint16_t *slot_refs;
+static struct lock swap_lock;
+
+/** Initializes swap space.  Without a swap device every
+   allocation fails, so only clean pages can be evicted. */
+void swap_init(void) {
+  size_t slot_cnt = 0;
+
+  swap_block = block_get_role(BLOCK_SWAP);
+  if (swap_block != NULL) slot_cnt = block_size(swap_block) / SECTORS_PER_PAGE;
+
+  lock_init(&swap_lock);
+  swap_map = bitmap_create(slot_cnt);
+  slot_refs = calloc(slot_cnt + 1, sizeof *slot_refs);
+  if (swap_map == NULL || slot_refs == NULL) PANIC("swap_init: cannot allocate swap map");
+  printf("swap: %zu slots available.\n", slot_cnt);
+}
+
+/** Allocates CNT adjacent slots and returns the first, or
+   SWAP_ERROR if no such run is free. */
+size_t swap_alloc(size_t cnt) {
+  size_t slot, i;
+
+  lock_acquire(&swap_lock);
+  slot = bitmap_scan_and_flip(swap_map, 0, cnt, false);
+  if (slot != SWAP_ERROR)
+    for (i = 0; i < cnt; i++) slot_refs[slot + i] = 1;
+  lock_release(&swap_lock);
+  return slot;
+}
+
+/** Adds a reference to SLOT, for a page that now shares it. */
+void swap_dup(size_t slot) {
+  lock_acquire(&swap_lock);
+  ASSERT(bitmap_test(swap_map, slot));
+  slot_refs[slot]++;
+  lock_release(&swap_lock);
+}
+
+/** Drops a reference to SLOT, freeing it when none remain. */
+void swap_free(size_t slot) {
+  lock_acquire(&swap_lock);
+  ASSERT(bitmap_test(swap_map, slot));
+  if (--slot_refs[slot] == 0) bitmap_reset(swap_map, slot);
+  lock_release(&swap_lock);
+}
+
+/** Reads the page in SLOT into KPAGE. */
+void swap_read(size_t slot, void *kpage) {
+  uint8_t *buf = kpage;
+  size_t i;
+
+  ASSERT(bitmap_test(swap_map, slot));
+  for (i = 0; i < SECTORS_PER_PAGE; i++) block_read(swap_block, slot * SECTORS_PER_PAGE + i, buf + i * BLOCK_SECTOR_SIZE);
+}
+
+/** Writes KPAGE to SLOT. */
+void swap_write(size_t slot, const void *kpage) {
+  const uint8_t *buf = kpage;
+  size_t i;
+
+  ASSERT(bitmap_test(swap_map, slot));
+  for (i = 0; i < SECTORS_PER_PAGE; i++) block_write(swap_block, slot * SECTORS_PER_PAGE + i, buf + i * BLOCK_SECTOR_SIZE);
+}
@@ -0,0 +1,17 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <bitmap.h>
+#include <stddef.h>
+
+/** Index of a page-sized slot on the swap device. */
+#define SWAP_ERROR BITMAP_ERROR
+
+void swap_init(void);
+size_t swap_alloc(size_t cnt);
+void swap_dup(size_t slot);
+void swap_free(size_t slot);
+void swap_read(size_t slot, void *kpage);
+void swap_write(size_t slot, const void *kpage);
+
+#endif /**< vm/swap.h */